@@ -0,0 +1,296 @@
+#include "Cache.h"
+#include "Symmetry.h"
+#include "Utils.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CACHE_MAGIC "SOLVEURI"
+#define CACHE_VERSION 1
+// The magic string and the version, padded so that the records stay aligned
+#define CACHE_HEADER_SIZE 16
+
+/**
+ * The fixed part of a record. It is followed by the canonical form of the
+ * graph, then by the labels in canonical order if the instance was solved
+ */
+typedef struct _cacheRecord {
+    uint64_t hash;
+    // The size of the whole record in bytes, a multiple of 8
+    int32_t length;
+    int32_t nbv;
+    int32_t nbe;
+    int32_t method;
+    int32_t k;
+    int32_t d;
+    int32_t search;
+    int32_t status;
+    int32_t attempts;
+    int32_t sweeps;
+} CacheRecord;
+
+long recordLength(int nbv, int nbe, int status) {
+    long ints = nbv + 3L * nbe + (status == CACHE_SOLVED ? nbv + nbe : 0);
+    long length = sizeof(CacheRecord) + ints * sizeof(int32_t);
+    return (length + 7) & ~7L;
+}
+
+/**
+ * Adds the record at the offset to the index, which grows to stay at most half full
+ */
+void indexRecord(SolutionCache* c, uint64_t hash, long offset) {
+    if (2 * (c->nbRecords + 1) > c->capacity) {
+        uint64_t* hashes = c->hashes;
+        long* offsets = c->offsets;
+        long capacity = c->capacity;
+        c->capacity = capacity ? 2 * capacity : 1024;
+        c->hashes = calloc(c->capacity, sizeof(uint64_t));
+        c->offsets = malloc(c->capacity * sizeof(long));
+        c->nbRecords = 0;
+        for (long i = 0; i < capacity; i++) {
+            if (hashes[i]) { indexRecord(c, hashes[i], offsets[i]); }
+        }
+        free(hashes);
+        free(offsets);
+    }
+    if (hash == 0) { hash = 1; }
+    long i = hash & (c->capacity - 1);
+    while (c->hashes[i]) {
+        i = (i + 1) & (c->capacity - 1);
+    }
+    c->hashes[i] = hash;
+    c->offsets[i] = offset;
+    c->nbRecords++;
+}
+
+/**
+ * Maps the file again if it grew, and indexes the new complete records
+ */
+void mapCache(SolutionCache* c) {
+    struct stat st;
+    if (fstat(c->fd, &st) != 0 || st.st_size <= c->size) { return; }
+    char* map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, c->fd, 0);
+    if (map == MAP_FAILED) { return; }
+    if (c->map) { munmap(c->map, c->size); }
+    c->map = map;
+    c->size = st.st_size;
+
+    while (c->end + (long)sizeof(CacheRecord) <= c->size) {
+        CacheRecord* r = (CacheRecord*)(c->map + c->end);
+        if (r->nbv < 0 || r->nbe < 0 || r->length != recordLength(r->nbv, r->nbe, r->status) ||
+            c->end + r->length > c->size) {
+            break;
+        }
+        indexRecord(c, r->hash, c->end);
+        c->end += r->length;
+    }
+}
+
+SolutionCache* openCache(char* filename) {
+    int fd = open(filename, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "Could not open the cache %s\n", filename);
+        return NULL;
+    }
+    struct stat st;
+    char header[CACHE_HEADER_SIZE] = CACHE_MAGIC;
+    header[sizeof(CACHE_MAGIC) - 1] = CACHE_VERSION;
+    if (fstat(fd, &st) != 0 ||
+        (st.st_size == 0 && write(fd, header, CACHE_HEADER_SIZE) != CACHE_HEADER_SIZE)) {
+        fprintf(stderr, "Could not write the cache %s\n", filename);
+        close(fd);
+        return NULL;
+    }
+
+    SolutionCache* c = malloc(sizeof(SolutionCache));
+    c->fd = fd;
+    c->map = NULL;
+    c->size = 0;
+    c->end = CACHE_HEADER_SIZE;
+    c->hashes = NULL;
+    c->offsets = NULL;
+    c->capacity = 0;
+    c->nbRecords = 0;
+    mapCache(c);
+    if (!c->map || c->size < CACHE_HEADER_SIZE ||
+        memcmp(c->map, header, CACHE_HEADER_SIZE) != 0) {
+        fprintf(stderr, "%s is not a cache of this version\n", filename);
+        closeCache(c);
+        return NULL;
+    }
+    // A record cut by a crash is dropped, so that the next ones are read
+    if (c->end < c->size && ftruncate(fd, c->end) == 0) {
+        fprintf(stderr, "Dropped an incomplete record at the end of the cache %s\n", filename);
+        munmap(c->map, c->size);
+        c->map = mmap(NULL, c->end, PROT_READ, MAP_SHARED, fd, 0);
+        c->size = c->end;
+    }
+    return c;
+}
+
+void closeCache(SolutionCache* c) {
+    if (c->map) { munmap(c->map, c->size); }
+    close(c->fd);
+    free(c->hashes);
+    free(c->offsets);
+    free(c);
+}
+
+/**
+ * Compares two edges as their triples (u, v, color), the edge index after them is ignored
+ */
+int cmpRankedEdge(const void* a, const void* b) {
+    const int* x = (const int*)a;
+    const int* y = (const int*)b;
+    for (int i = 0; i < 3; i++) {
+        if (x[i] != y[i]) { return x[i] < y[i] ? -1 : 1; }
+    }
+    return 0;
+}
+
+CacheKey* createCacheKey(Graph* g, int method, int k, int d, int search, int* labels,
+                         int* frozen, int nbFrozen) {
+    int n = g->nbv;
+    int m = g->nbe;
+    CacheKey* key = malloc(sizeof(CacheKey));
+    key->nbv = n;
+    key->nbe = m;
+    key->method = method;
+    key->k = k;
+    key->d = d;
+    key->search = search;
+    key->form = malloc((n + 3 * m + 1) * sizeof(int));
+    key->elementAt = malloc((n + m + 1) * sizeof(int));
+
+    // A frozen label is a color of its element, the others are 0
+    int* colors = calloc(n + m + 1, sizeof(int));
+    for (int i = 0; i < n + m && frozen; i++) {
+        if (inTab(labels[i], frozen, nbFrozen)) { colors[i] = labels[i]; }
+    }
+    int* position = malloc((n + 1) * sizeof(int));
+    canonicalGraph(g, frozen ? colors : NULL, frozen ? colors + n : NULL, position, key->form);
+
+    int* ends = malloc((2 * m + 1) * sizeof(int));
+    int* edges = malloc((4 * m + 1) * sizeof(int));
+    getEdgesEndpoints(g, ends);
+    for (int v = 0; v < n; v++) {
+        key->elementAt[position[v]] = v;
+    }
+    for (int i = 0; i < m; i++) {
+        int u = position[ends[2 * i]];
+        int v = position[ends[2 * i + 1]];
+        edges[4 * i] = u < v ? u : v;
+        edges[4 * i + 1] = u < v ? v : u;
+        edges[4 * i + 2] = colors[n + i];
+        edges[4 * i + 3] = i;
+    }
+    // The edges with the same triple are interchangeable
+    qsort(edges, m, 4 * sizeof(int), cmpRankedEdge);
+    for (int i = 0; i < m; i++) {
+        key->elementAt[n + i] = n + edges[4 * i + 3];
+    }
+
+    // FNV-1a, then a final mix so that the low bits are usable as an index
+    int params[5] = {n, m, method, k, d};
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < 5 + n + 3 * m; i++) {
+        h ^= (uint32_t)(i < 5 ? params[i] : key->form[i - 5]);
+        h *= 0x100000001b3ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    key->hash = h;
+
+    free(colors);
+    free(position);
+    free(ends);
+    free(edges);
+    return key;
+}
+
+void freeCacheKey(CacheKey* key) {
+    free(key->form);
+    free(key->elementAt);
+    free(key);
+}
+
+/**
+ * @return 1 if the record is about the instance of the key, whatever the search, 0 if not
+ */
+int matchesKey(CacheRecord* r, CacheKey* key) {
+    if (r->nbv != key->nbv || r->nbe != key->nbe || r->method != key->method ||
+        r->k != key->k || r->d != key->d) {
+        return 0;
+    }
+    return !memcmp(r + 1, key->form, (key->nbv + 3 * key->nbe) * sizeof(int32_t));
+}
+
+int lookupCache(SolutionCache* c, CacheKey* key, int* labels, int* attempts, int* sweeps) {
+    int res = CACHE_MISS;
+    *attempts = 0;
+    *sweeps = 0;
+    if (!c->capacity) { return res; }
+    uint64_t hash = key->hash ? key->hash : 1;
+    for (long i = hash & (c->capacity - 1); c->hashes[i]; i = (i + 1) & (c->capacity - 1)) {
+        if (c->hashes[i] != hash) { continue; }
+        CacheRecord* r = (CacheRecord*)(c->map + c->offsets[i]);
+        if (!matchesKey(r, key)) { continue; }
+        if (r->status == CACHE_SOLVED) {
+            int32_t* stored = (int32_t*)(r + 1) + key->nbv + 3 * key->nbe;
+            for (int j = 0; j < key->nbv + key->nbe; j++) {
+                labels[key->elementAt[j]] = stored[j];
+            }
+            return CACHE_SOLVED;
+        }
+        // A proof holds whatever the search, a failure only for its own search
+        if (r->status == CACHE_IMPOSSIBLE) {
+            res = CACHE_IMPOSSIBLE;
+        } else if (r->search == key->search && res != CACHE_IMPOSSIBLE) {
+            res = CACHE_FAILED;
+            if (r->attempts > *attempts) { *attempts = r->attempts; }
+            if (r->sweeps > *sweeps) { *sweeps = r->sweeps; }
+        }
+    }
+    return res;
+}
+
+int storeCache(SolutionCache* c, CacheKey* key, int status, int* labels, int attempts,
+               int sweeps) {
+    long length = recordLength(key->nbv, key->nbe, status);
+    char* buffer = calloc(1, length);
+    CacheRecord* r = (CacheRecord*)buffer;
+    r->hash = key->hash;
+    r->length = length;
+    r->nbv = key->nbv;
+    r->nbe = key->nbe;
+    r->method = key->method;
+    r->k = key->k;
+    r->d = key->d;
+    r->search = key->search;
+    r->status = status;
+    r->attempts = attempts;
+    r->sweeps = sweeps;
+    int32_t* data = (int32_t*)(r + 1);
+    memcpy(data, key->form, (key->nbv + 3 * key->nbe) * sizeof(int32_t));
+    if (status == CACHE_SOLVED) {
+        data += key->nbv + 3 * key->nbe;
+        for (int j = 0; j < key->nbv + key->nbe; j++) {
+            data[j] = labels[key->elementAt[j]];
+        }
+    }
+    // A single append, so that the records of several processes do not interleave
+    int written = write(c->fd, buffer, length) == length;
+    free(buffer);
+    if (!written) {
+        fprintf(stderr, "Could not append to the cache\n");
+        return 0;
+    }
+    mapCache(c);
+    return 1;
+}
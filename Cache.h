@@ -0,0 +1,117 @@
+#pragma once
+
+#include "Graph.h"
+
+#include <stdint.h>
+
+#define CACHE_MISS 0
+#define CACHE_SOLVED 1
+// Not solved within a budget of attempts and sweeps
+#define CACHE_FAILED 2
+// Proved to have no solution by the exact solver
+#define CACHE_IMPOSSIBLE 3
+
+/**
+ * A file of the instances already solved, or not solved within a budget.
+ * The file is append-only, and read through a memory mapping: the records are
+ * found with an index of their hashes, built when the file is opened.
+ * Records appended by other processes are seen once the file is mapped again,
+ * after an append or at the next opening.
+ *
+ * Use the openCache function to properly create one
+ */
+typedef struct _solutionCache {
+    int fd;
+    char* map;
+    long size;
+    // The end of the last complete record
+    long end;
+    // Open addressing, 0 marks the empty slots of the hashes
+    uint64_t* hashes;
+    long* offsets;
+    long capacity;
+    long nbRecords;
+} SolutionCache;
+
+/**
+ * An instance in the coordinates of the canonical form of its graph, so that
+ * isomorphic instances have the same key.
+ *
+ * Use the createCacheKey function to properly create one
+ */
+typedef struct _cacheKey {
+    uint64_t hash;
+    int nbv;
+    int nbe;
+    int method;
+    int k;
+    int d;
+    int search;
+    // The canonical form of the graph, with the frozen labels as colors
+    int* form;
+    // The element of the graph at each canonical rank, vertices first then edges
+    int* elementAt;
+} CacheKey;
+
+/**
+ * Opens the cache file, creates it if it does not exist
+ * @param filename The name of the file
+ * @return The pointer to the allocated cache, NULL if the file could not be opened
+ * or is not a cache
+ */
+SolutionCache* openCache(char* filename);
+
+/**
+ * Frees the memory of the cache and closes its file
+ * @param c The cache to close
+ */
+void closeCache(SolutionCache* c);
+
+/**
+ * Computes the key of an instance
+ * @param g The graph to solve
+ * @param method The method of the objective, see attemptSolveWithSolver
+ * @param k The constant of the objective
+ * @param d The step of the objective
+ * @param search The search used, failures are only shared between the same searches
+ * @param labels The labels of the graph, vertices first then edges
+ * @param frozen The labels that stay where they are in labels, NULL if none
+ * @param nbFrozen The number of frozen labels
+ * @return The pointer to the allocated key
+ */
+CacheKey* createCacheKey(Graph* g, int method, int k, int d, int search, int* labels,
+                         int* frozen, int nbFrozen);
+
+/**
+ * Frees the memory of the key
+ * @param key The key to free
+ */
+void freeCacheKey(CacheKey* key);
+
+/**
+ * Looks an instance up. A solution is preferred to a proof that there is none,
+ * which is found whatever the search, then to a failure of the same search, and
+ * the largest budget of the failures is given
+ * @param c The cache to search
+ * @param key The key of the instance
+ * @param labels Where the labels of the solution are stored, in the order of the
+ * elements of the graph of the key
+ * @param attempts Where the number of attempts of a failure is stored
+ * @param sweeps Where the number of sweeps of a failure is stored
+ * @return CACHE_MISS, CACHE_SOLVED, CACHE_FAILED or CACHE_IMPOSSIBLE
+ */
+int lookupCache(SolutionCache* c, CacheKey* key, int* labels, int* attempts, int* sweeps);
+
+/**
+ * Appends a record to the cache file
+ * @param c The cache to write in
+ * @param key The key of the instance
+ * @param status CACHE_SOLVED, CACHE_FAILED or CACHE_IMPOSSIBLE
+ * @param labels The labels of the solution, in the order of the elements of the
+ * graph of the key, NULL if it was not solved
+ * @param attempts The number of attempts made
+ * @param sweeps The maximum number of sweeps of an attempt
+ * @return 1 if the record was written, 0 if not
+ */
+int storeCache(SolutionCache* c, CacheKey* key, int status, int* labels, int attempts,
+               int sweeps);
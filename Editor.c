@@ -217,10 +217,8 @@ Graph* bipartiteCmd(char* argBuff) {
 
     Rectangle* r = createRectangle("editor", n, m);
     Graph* res = r->g;
-    for (int i = 0; i < r->height; i++) {
-        free(r->table[i]);
-    }
     free(r->table);
+    free(r->cellToEdge);
     free(r);
     strcpy(res->name, "CompleteBipartite_Editor");
     relabelGraph(res);
@@ -405,8 +403,8 @@ void linkLogic(Graph* g, char* argBuff) {
     int edgeCount = 0;
     int previousIgnored = 0;
     while (1) {
-        char labelForEdge[MAX_ORDER_NUMERALS];
-        wordSize = parseWord(nxtIndex, BUFFER_SIZE - 1, argBuff, labelForEdge);
+        char labelForEdge[MAX_ORDER_NUMERALS + 1];
+        wordSize = parseWord(nxtIndex, MAX_ORDER_NUMERALS, argBuff, labelForEdge);
 
         if (wordSize == 1) {
             if (previousIgnored || edgeCount) break;
@@ -0,0 +1,541 @@
+#include "Exact.h"
+#include "Graph.h"
+#include "Solver.h"
+#include "Symmetry.h"
+#include "Utils.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * What all the threads share: the graph with indexed vertices, the order in
+ * which the elements are labelled, and the weights to reach.
+ * The elements are the vertices first, then the edges.
+ */
+typedef struct _exactProblem {
+    int nbv;
+    int nbe;
+    int nbl;
+    int* ends;
+    int* order;
+    // The label of v must be lower than the labels of above[aboveStart[v]..aboveStart[v+1]-1]
+    int* aboveStart;
+    int* above;
+    // The label of v must be higher than the labels of below[belowStart[v]..belowStart[v+1]-1]
+    int* belowStart;
+    int* below;
+    // The weights must be a, a+d, ..., a+(nbv-1)d
+    int a;
+    int d;
+    long edgeSum;
+    // Each subtree is given by the labels of the depth first elements
+    int* tasks;
+    int nbTasks;
+    int maxTasks;
+    int depth;
+    int collecting;
+    int nextTask;
+    int found;
+    int* solution;
+    long nodes;
+    pthread_mutex_t lock;
+} ExactProblem;
+
+/**
+ * The partial labelling explored by a thread
+ */
+typedef struct _exactState {
+    ExactProblem* p;
+    int* labels;
+    long* partial;
+    int* remaining;
+    int* marked;
+    // The bit x-1 is set if the label x is still free
+    uint64_t freeLabels;
+    // The bit i is set if no vertex has the weight a+i*d yet
+    uint64_t freeWeights;
+    long edgeSum;
+    int edgesLeft;
+    long nodes;
+} ExactState;
+
+/**
+ * @return The sum of the r smallest free labels
+ */
+long minFree(uint64_t mask, int r) {
+    long res = 0;
+    for (int i = 0; i < r && mask; i++) {
+        res += __builtin_ctzll(mask) + 1;
+        mask &= mask - 1;
+    }
+    return res;
+}
+
+/**
+ * @return The sum of the r largest free labels
+ */
+long maxFree(uint64_t mask, int r) {
+    long res = 0;
+    for (int i = 0; i < r && mask; i++) {
+        int top = 63 - __builtin_clzll(mask);
+        res += top + 1;
+        mask &= ~(1ULL << top);
+    }
+    return res;
+}
+
+/**
+ * Checks that the vertex v can still reach one of the wanted weights.
+ * If all its elements are labelled, its weight is reserved.
+ * @return 1 if the partial labelling is still consistent, 0 if not
+ */
+int checkVertex(ExactState* st, int v) {
+    ExactProblem* p = st->p;
+    long w = st->partial[v];
+    if (st->remaining[v] == 0) {
+        long i = w - p->a;
+        if (p->d == 0) { return i == 0; }
+        if (i < 0 || i % p->d != 0 || i / p->d >= p->nbv) { return 0; }
+        i = i / p->d;
+        if (!((st->freeWeights >> i) & 1)) { return 0; }
+        st->freeWeights &= ~(1ULL << i);
+        st->marked[v] = 1;
+        return 1;
+    }
+    long lo = p->a;
+    long hi = p->a + (long)(p->nbv - 1) * p->d;
+    return w + minFree(st->freeLabels, st->remaining[v]) <= hi &&
+           w + maxFree(st->freeLabels, st->remaining[v]) >= lo;
+}
+
+/**
+ * Gets the vertices an element contributes to
+ * @return The number of vertices stored in touched
+ */
+int touchedVertices(ExactProblem* p, int e, int* touched) {
+    if (e < p->nbv) {
+        touched[0] = e;
+        return 1;
+    }
+    touched[0] = p->ends[2 * (e - p->nbv)];
+    touched[1] = p->ends[2 * (e - p->nbv) + 1];
+    return 2;
+}
+
+/**
+ * Labels the element e with x, then checks the partial labelling.
+ * Whatever the result, unassign must be called to undo it
+ * @return 1 if the partial labelling is still consistent, 0 if not
+ */
+int assign(ExactState* st, int e, int x) {
+    ExactProblem* p = st->p;
+    int touched[2];
+    int nb = touchedVertices(p, e, touched);
+
+    st->labels[e] = x;
+    st->freeLabels &= ~(1ULL << (x - 1));
+    for (int i = 0; i < nb; i++) {
+        st->partial[touched[i]] += x;
+        st->remaining[touched[i]]--;
+    }
+    if (e >= p->nbv) {
+        st->edgeSum += x;
+        st->edgesLeft--;
+    } else {
+        // Symmetry breaking
+        for (int i = p->aboveStart[e]; i < p->aboveStart[e + 1]; i++) {
+            int w = st->labels[p->above[i]];
+            if (w && w < x) { return 0; }
+        }
+        for (int i = p->belowStart[e]; i < p->belowStart[e + 1]; i++) {
+            if (st->labels[p->below[i]] > x) { return 0; }
+        }
+    }
+
+    for (int i = 0; i < nb; i++) {
+        if (!checkVertex(st, touched[i])) { return 0; }
+    }
+    return st->edgeSum + minFree(st->freeLabels, st->edgesLeft) <= p->edgeSum &&
+           st->edgeSum + maxFree(st->freeLabels, st->edgesLeft) >= p->edgeSum;
+}
+
+/**
+ * Undoes the labelling of the element e with x
+ */
+void unassign(ExactState* st, int e, int x) {
+    ExactProblem* p = st->p;
+    int touched[2];
+    int nb = touchedVertices(p, e, touched);
+
+    for (int i = 0; i < nb; i++) {
+        int v = touched[i];
+        if (st->marked[v]) {
+            st->freeWeights |= 1ULL << ((st->partial[v] - p->a) / p->d);
+            st->marked[v] = 0;
+        }
+        st->partial[v] -= x;
+        st->remaining[v]++;
+    }
+    if (e >= p->nbv) {
+        st->edgeSum -= x;
+        st->edgesLeft++;
+    }
+    st->labels[e] = 0;
+    st->freeLabels |= 1ULL << (x - 1);
+}
+
+void saveExactSolution(ExactState* st) {
+    ExactProblem* p = st->p;
+    pthread_mutex_lock(&p->lock);
+    if (!p->found) {
+        memcpy(p->solution, st->labels, p->nbl * sizeof(int));
+        __atomic_store_n(&p->found, 1, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&p->lock);
+}
+
+int exactSearch(ExactState* st, int pos);
+
+/**
+ * Labels the element at position pos with x and explores the subtree
+ * @return 1 if a solution was found
+ */
+int tryLabel(ExactState* st, int pos, int x) {
+    int e = st->p->order[pos];
+    if (x < 1 || x > st->p->nbl || !((st->freeLabels >> (x - 1)) & 1)) { return 0; }
+    if (assign(st, e, x) && exactSearch(st, pos + 1)) { return 1; }
+    unassign(st, e, x);
+    return 0;
+}
+
+/**
+ * Depth first search of a solution from the position pos of the order.
+ * When collecting, the subtrees at the wanted depth are stored as tasks instead
+ * @return 1 if a solution was found
+ */
+int exactSearch(ExactState* st, int pos) {
+    ExactProblem* p = st->p;
+    if (__atomic_load_n(&p->found, __ATOMIC_ACQUIRE)) { return 0; }
+    st->nodes++;
+
+    if (pos == p->nbl) {
+        saveExactSolution(st);
+        return 1;
+    }
+
+    if (p->collecting && pos == p->depth) {
+        if (p->nbTasks == p->maxTasks) {
+            p->maxTasks = 2 * p->maxTasks + 16;
+            p->tasks = realloc(p->tasks, p->maxTasks * p->depth * sizeof(int));
+        }
+        for (int i = 0; i < p->depth; i++) {
+            p->tasks[p->nbTasks * p->depth + i] = st->labels[p->order[i]];
+        }
+        p->nbTasks++;
+        return 0;
+    }
+
+    int e = p->order[pos];
+    int touched[2];
+    int nb = touchedVertices(p, e, touched);
+
+    // If e is the last element of a vertex, its weight decides the label
+    int closing = -1;
+    for (int i = 0; i < nb; i++) {
+        if (st->remaining[touched[i]] == 1) { closing = touched[i]; }
+    }
+
+    if (closing != -1) {
+        if (p->d == 0) { return tryLabel(st, pos, p->a - st->partial[closing]); }
+        for (int i = 0; i < p->nbv; i++) {
+            if (!((st->freeWeights >> i) & 1)) { continue; }
+            if (tryLabel(st, pos, p->a + i * p->d - st->partial[closing])) { return 1; }
+        }
+        return 0;
+    }
+
+    uint64_t mask = st->freeLabels;
+    while (mask) {
+        int x = __builtin_ctzll(mask) + 1;
+        mask &= mask - 1;
+        if (tryLabel(st, pos, x)) { return 1; }
+    }
+    return 0;
+}
+
+ExactState* createExactState(ExactProblem* p) {
+    ExactState* st = malloc(sizeof(ExactState));
+    st->p = p;
+    st->labels = calloc(p->nbl, sizeof(int));
+    st->partial = calloc(p->nbv, sizeof(long));
+    st->remaining = malloc(p->nbv * sizeof(int));
+    st->marked = calloc(p->nbv, sizeof(int));
+    for (int i = 0; i < p->nbv; i++) {
+        st->remaining[i] = 1;
+    }
+    for (int i = 0; i < 2 * p->nbe; i++) {
+        st->remaining[p->ends[i]]++;
+    }
+    st->freeLabels = (p->nbl == 64) ? ~0ULL : (1ULL << p->nbl) - 1;
+    st->freeWeights = (p->nbv == 64) ? ~0ULL : (1ULL << p->nbv) - 1;
+    st->edgeSum = 0;
+    st->edgesLeft = p->nbe;
+    st->nodes = 0;
+    return st;
+}
+
+void freeExactState(ExactState* st) {
+    free(st->labels);
+    free(st->partial);
+    free(st->remaining);
+    free(st->marked);
+    free(st);
+}
+
+void* exactWorker(void* arg) {
+    ExactState* st = (ExactState*)arg;
+    ExactProblem* p = st->p;
+    while (!__atomic_load_n(&p->found, __ATOMIC_ACQUIRE)) {
+        int t = __atomic_fetch_add(&p->nextTask, 1, __ATOMIC_RELAXED);
+        if (t >= p->nbTasks) { break; }
+
+        // Replaying the labels of the root of the subtree
+        int* prefix = p->tasks + t * p->depth;
+        for (int i = 0; i < p->depth; i++) {
+            assign(st, p->order[i], prefix[i]);
+        }
+        if (exactSearch(st, p->depth)) { break; }
+        for (int i = p->depth - 1; i >= 0; i--) {
+            unassign(st, p->order[i], prefix[i]);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Searches the solutions for the constant and step of the problem,
+ * splitting the tree between the threads
+ * @return 1 if a solution was found, 0 if not
+ */
+int exactSolveConstant(ExactProblem* p, int nbThreads) {
+    p->found = 0;
+
+    // The subtrees are the labellings of the first elements, we go deep enough
+    // to have many more subtrees than threads
+    ExactState* st = createExactState(p);
+    p->collecting = 1;
+    p->depth = 0;
+    p->nbTasks = 1;
+    while (p->depth < p->nbl && p->depth < 4 && p->nbTasks < 64 * nbThreads) {
+        p->depth++;
+        p->nbTasks = 0;
+        p->maxTasks = 0;
+        free(p->tasks);
+        p->tasks = NULL;
+        exactSearch(st, 0);
+        if (p->found) { break; }
+    }
+    p->collecting = 0;
+    p->nodes += st->nodes;
+    freeExactState(st);
+    if (p->found) { return 1; }
+
+    p->nextTask = 0;
+    pthread_t threads[nbThreads];
+    ExactState* states[nbThreads];
+    for (int i = 0; i < nbThreads; i++) {
+        states[i] = createExactState(p);
+        pthread_create(&threads[i], NULL, exactWorker, states[i]);
+    }
+    for (int i = 0; i < nbThreads; i++) {
+        pthread_join(threads[i], NULL);
+        p->nodes += states[i]->nodes;
+        freeExactState(states[i]);
+    }
+    return p->found;
+}
+
+/**
+ * Orders the elements so that the vertices are completed as soon as possible:
+ * the vertex with the most labelled issued edges comes next, followed by its
+ * issued edges that are not labelled yet
+ */
+void exactOrder(ExactProblem* p) {
+    int nbv = p->nbv;
+    int* degrees = calloc(nbv, sizeof(int));
+    int* placedEdges = calloc(nbv, sizeof(int));
+    int* done = calloc(nbv, sizeof(int));
+    int* edgeDone = calloc(p->nbe, sizeof(int));
+    for (int i = 0; i < 2 * p->nbe; i++) {
+        degrees[p->ends[i]]++;
+    }
+
+    int pos = 0;
+    for (int step = 0; step < nbv; step++) {
+        int best = -1;
+        for (int v = 0; v < nbv; v++) {
+            if (done[v]) { continue; }
+            if (best == -1 || placedEdges[v] > placedEdges[best] ||
+                (placedEdges[v] == placedEdges[best] && degrees[v] > degrees[best])) {
+                best = v;
+            }
+        }
+        done[best] = 1;
+        p->order[pos++] = best;
+        for (int e = 0; e < p->nbe; e++) {
+            if (edgeDone[e]) { continue; }
+            if (p->ends[2 * e] != best && p->ends[2 * e + 1] != best) { continue; }
+            edgeDone[e] = 1;
+            p->order[pos++] = nbv + e;
+            placedEdges[p->ends[2 * e]]++;
+            placedEdges[p->ends[2 * e + 1]]++;
+        }
+    }
+    free(degrees);
+    free(placedEdges);
+    free(done);
+    free(edgeDone);
+}
+
+/**
+ * Any automorphism maps a solution to a solution, so only the solutions where
+ * each base point b_i of the stabilizer chain has a lower label than the rest
+ * of its orbit are searched. Applying an automorphism fixing b0, ..., b_(i-1)
+ * keeps the constraints on the previous base points, so every solution has an
+ * equivalent one satisfying all of them
+ */
+void exactSymmetry(ExactProblem* p, Graph* g) {
+    int nbv = p->nbv;
+    // The vertices are picked as base points in the order they are labelled
+    int* vertexOrder = malloc(nbv * sizeof(int));
+    int cpt = 0;
+    for (int i = 0; i < p->nbl; i++) {
+        if (p->order[i] < nbv) { vertexOrder[cpt++] = p->order[i]; }
+    }
+    Symmetry* sym = computeSymmetry(g, vertexOrder);
+    free(vertexOrder);
+
+    int nbPairs = sym->orbitStart[sym->baseSize];
+    p->aboveStart = calloc(nbv + 1, sizeof(int));
+    p->belowStart = calloc(nbv + 1, sizeof(int));
+    p->above = malloc((nbPairs + 1) * sizeof(int));
+    p->below = malloc((nbPairs + 1) * sizeof(int));
+    for (int i = 0; i < sym->baseSize; i++) {
+        for (int j = sym->orbitStart[i]; j < sym->orbitStart[i + 1]; j++) {
+            if (sym->orbits[j] == sym->base[i]) { continue; }
+            p->aboveStart[sym->base[i] + 1]++;
+            p->belowStart[sym->orbits[j] + 1]++;
+        }
+    }
+    for (int v = 0; v < nbv; v++) {
+        p->aboveStart[v + 1] += p->aboveStart[v];
+        p->belowStart[v + 1] += p->belowStart[v];
+    }
+    int* fillAbove = malloc(nbv * sizeof(int));
+    int* fillBelow = malloc(nbv * sizeof(int));
+    memcpy(fillAbove, p->aboveStart, nbv * sizeof(int));
+    memcpy(fillBelow, p->belowStart, nbv * sizeof(int));
+    for (int i = 0; i < sym->baseSize; i++) {
+        int b = sym->base[i];
+        for (int j = sym->orbitStart[i]; j < sym->orbitStart[i + 1]; j++) {
+            int w = sym->orbits[j];
+            if (w == b) { continue; }
+            p->above[fillAbove[b]++] = w;
+            p->below[fillBelow[w]++] = b;
+        }
+    }
+    free(fillAbove);
+    free(fillBelow);
+    freeSymmetry(sym);
+}
+
+int solveExact(Graph* g, int a, int d, int nbThreads, long* nodes) {
+    int nbv = g->nbv;
+    int nbe = g->nbe;
+    int nbl = nbv + nbe;
+    if (nbl > EXACT_MAX_LABELS || nbv == 0) {
+        fprintf(stderr, "Graph %s is too large for the exact solver (%d labels, at most %d)\n",
+                g->name, nbl, EXACT_MAX_LABELS);
+        return -1;
+    }
+    if (nbThreads < 1) { nbThreads = 1; }
+
+    ExactProblem p;
+    p.nbv = nbv;
+    p.nbe = nbe;
+    p.nbl = nbl;
+    p.ends = malloc(2 * nbe * sizeof(int));
+    getEdgesEndpoints(g, p.ends);
+    p.order = malloc(nbl * sizeof(int));
+    p.tasks = NULL;
+    p.maxTasks = 0;
+    p.solution = malloc(nbl * sizeof(int));
+    p.nodes = 0;
+    pthread_mutex_init(&p.lock, NULL);
+    exactOrder(&p);
+    exactSymmetry(&p, g);
+
+    // A step d < 0 gives the same weights as the step -d from the largest one
+    if (d < 0) {
+        if (a) { a = a + (nbv - 1) * d; }
+        d = -d;
+    }
+
+    // The sum of the weights counts the vertices once and the edges twice
+    long total = (long)nbl * (nbl + 1) / 2;
+    long minEdges = (long)nbe * (nbe + 1) / 2;
+    long maxEdges = (long)nbe * (2 * nbl - nbe + 1) / 2;
+    long steps = (long)d * nbv * (nbv - 1) / 2;
+    int min = a;
+    int max = a;
+    if (!a) {
+        if (d == 0) {
+            min = getMinMagicConst(g);
+            max = getMaxMagicConst(g);
+        } else {
+            min = (total + minEdges - steps + nbv - 1) / nbv;
+            max = (total + maxEdges - steps) / nbv;
+        }
+    }
+
+    int found = 0;
+    for (int c = min; c <= max && !found; c++) {
+        p.a = c;
+        p.d = d;
+        p.edgeSum = (long)nbv * c + steps - total;
+        if (p.edgeSum < minEdges || p.edgeSum > maxEdges) { continue; }
+        found = exactSolveConstant(&p, nbThreads);
+    }
+
+    if (found) {
+        setLabels(g, p.solution);
+        if (d == 0) {
+            printf(ANSI_COLOR_GREEN "Successfully solved %s for a %d-VMT with the exact solver (%ld nodes)" ANSI_RESET_ALL "\n",
+                   g->name, p.a, p.nodes);
+        } else {
+            printf(ANSI_COLOR_GREEN "Successfully solved %s for a (%d, %d)-VAT with the exact solver (%ld nodes)" ANSI_RESET_ALL "\n",
+                   g->name, p.a, d, p.nodes);
+        }
+    } else if (d == 0) {
+        printf(ANSI_COLOR_RED "Proved that %s has no k-VMT for k in [%d, %d] (exhaustive search, %ld nodes)" ANSI_RESET_ALL "\n",
+               g->name, min, max, p.nodes);
+    } else {
+        printf(ANSI_COLOR_RED "Proved that %s has no (a, %d)-VAT for a in [%d, %d] (exhaustive search, %ld nodes)" ANSI_RESET_ALL "\n",
+               g->name, d, min, max, p.nodes);
+    }
+
+    if (nodes) { *nodes = p.nodes; }
+    pthread_mutex_destroy(&p.lock);
+    free(p.ends);
+    free(p.order);
+    free(p.aboveStart);
+    free(p.above);
+    free(p.belowStart);
+    free(p.below);
+    free(p.tasks);
+    free(p.solution);
+    return found;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Graph.h"
+
+/**
+ * The largest number of labels (vertices and edges) the exact solver accepts
+ */
+#define EXACT_MAX_LABELS 63
+
+/**
+ * Exhaustively searches a (a,d)-VAT of the graph, or a k-VMT when d is 0.
+ * Partial weights are bounded with the labels that are still free, the
+ * last label of a vertex is forced when its weight is known, and the
+ * symmetries of the graph are broken so that equivalent branches are not
+ * explored twice. The search tree is split in subtrees solved in parallel.
+ *
+ * If no solution exists, the search is a proof of it: every labelling
+ * that could be a solution was ruled out.
+ *
+ * @param g The graph to solve. Its labels are replaced by the solution if
+ * one is found, and left untouched otherwise
+ * @param a The magic constant k of the VMT or the constant a of the VAT,
+ * 0 to try every feasible constant
+ * @param d The step of the VAT, 0 for a VMT
+ * @param nbThreads The number of threads to use
+ * @param nodes If not NULL, stores the number of nodes of the search tree
+ * @return 1 if a solution was found, 0 if none exists, -1 if the graph is
+ * too large for the exact solver
+ */
+int solveExact(Graph* g, int a, int d, int nbThreads, long* nodes);
@@ -8,22 +8,22 @@
 #include <string.h>
 
 Vertex createVertex(char* name, int label) {
-    Vertex* v = (Vertex*)malloc(sizeof(Vertex));
-    v->label = label;
+    Vertex v;
+    v.label = label;
     char* buff = malloc(BUFFER_SIZE * sizeof(char));
     sprintf(buff, "%s", name);
-    v->name = buff;
-    return *v;
+    v.name = buff;
+    return v;
 }
 Edge createEdge(char* name, int label, Vertex v1, Vertex v2) {
-    Edge* e = (Edge*)malloc(sizeof(Edge));
-    e->label = label;
+    Edge e;
+    e.label = label;
     char* buff = malloc(BUFFER_SIZE * sizeof(char));
     sprintf(buff, "%s", name);
-    e->name = buff;
-    e->vertices[0] = v1;
-    e->vertices[1] = v2;
-    return *e;
+    e.name = buff;
+    e.vertices[0] = v1;
+    e.vertices[1] = v2;
+    return e;
 }
 
 Graph* createGraph(char* name, int nbvMAX) {
@@ -73,11 +73,11 @@ void freeGraph(Graph* g) {
 
 int addVertex(Graph* g, Vertex v) {
     if (g->nbv == g->nbvMAX) {
-        printf(ANSI_COLOR_YELLOW
-               "WARNING: Ignored the vertex %s "
-               "when trying to add it to the graph %s "
-               "because it has too many vertices" ANSI_RESET_ALL "\n",
-               v.name, g->name);
+        fprintf(stderr, ANSI_COLOR_YELLOW
+                "WARNING: Ignored the vertex %s "
+                "when trying to add it to the graph %s "
+                "because it has too many vertices" ANSI_RESET_ALL "\n",
+                v.name, g->name);
         return 0;
     }
     if (g->nbv > g->nbvMAX) { g->nbv = 0; }
@@ -88,11 +88,11 @@ int addVertex(Graph* g, Vertex v) {
 
 int addEdge(Graph* g, Edge e) {
     if (g->nbe == g->nbeMAX) {
-        printf(ANSI_COLOR_YELLOW "WARNING: Ignored the edge %s "
-                                 "when trying to add it to the graph %s "
-                                 "because it has too many edges" ANSI_RESET_ALL
-                                 "\n",
-               e.name, g->name);
+        fprintf(stderr, ANSI_COLOR_YELLOW "WARNING: Ignored the edge %s "
+                                          "when trying to add it to the graph %s "
+                                          "because it has too many edges" ANSI_RESET_ALL
+                                          "\n",
+                e.name, g->name);
         return 0;
     }
 
@@ -102,20 +102,82 @@ int addEdge(Graph* g, Edge e) {
     return 1;
 }
 Graph* cloneGraph(Graph* g) {
-    char buff[100];
-    sprintf(buff, "%s_clone", g->name);
+    char buff[BUFFER_SIZE];
+    snprintf(buff, BUFFER_SIZE, "%s_clone", g->name);
 
     Graph* clone = createGraph(buff, g->nbvMAX);
 
     for (int i = 0; i < g->nbv; i++) {
-        addVertex(clone, g->vertices[i]);
+        addVertex(clone, createVertex(g->vertices[i].name, g->vertices[i].label));
     }
+
+    // The edges must refer to the vertices of the clone, not the original ones
+    int* ends = malloc(2 * g->nbe * sizeof(int));
+    getEdgesEndpoints(g, ends);
     for (int i = 0; i < g->nbe; i++) {
-        addEdge(clone, g->edges[i]);
+        addEdge(clone, createEdge(g->edges[i].name, g->edges[i].label,
+                                  clone->vertices[ends[2 * i]],
+                                  clone->vertices[ends[2 * i + 1]]));
     }
+    free(ends);
     return clone;
 }
 
+void getEdgesEndpoints(Graph* g, int* ends) {
+    // Vertices are identified by their name pointer, so we hash those
+    // pointers in an open addressing table to avoid a quadratic search
+    int size = 1;
+    while (size < 2 * g->nbv) {
+        size *= 2;
+    }
+    int* table = malloc(size * sizeof(int));
+    for (int i = 0; i < size; i++) {
+        table[i] = -1;
+    }
+
+    for (int i = 0; i < g->nbv; i++) {
+        unsigned long h = ((unsigned long)g->vertices[i].name >> 4) * 0x9E3779B97F4A7C15UL;
+        int pos = (int)(h >> 32) & (size - 1);
+        while (table[pos] != -1) {
+            pos = (pos + 1) & (size - 1);
+        }
+        table[pos] = i;
+    }
+
+    for (int i = 0; i < 2 * g->nbe; i++) {
+        char* name = g->edges[i / 2].vertices[i % 2].name;
+        unsigned long h = ((unsigned long)name >> 4) * 0x9E3779B97F4A7C15UL;
+        int pos = (int)(h >> 32) & (size - 1);
+        ends[i] = -1;
+        while (table[pos] != -1) {
+            if (g->vertices[table[pos]].name == name) {
+                ends[i] = table[pos];
+                break;
+            }
+            pos = (pos + 1) & (size - 1);
+        }
+    }
+    free(table);
+}
+
+void getLabels(Graph* g, int* labels) {
+    for (int i = 0; i < g->nbv; i++) {
+        labels[i] = g->vertices[i].label;
+    }
+    for (int i = 0; i < g->nbe; i++) {
+        labels[g->nbv + i] = g->edges[i].label;
+    }
+}
+
+void setLabels(Graph* g, int* labels) {
+    for (int i = 0; i < g->nbv; i++) {
+        g->vertices[i].label = labels[i];
+    }
+    for (int i = 0; i < g->nbe; i++) {
+        g->edges[i].label = labels[g->nbv + i];
+    }
+}
+
 void deleteEdge(Graph* g, Edge e) {
     int ok = 1;
     for (int i = 0; i < g->nbe; i++) {
@@ -186,26 +248,47 @@ int* logicalOrTab(int* t1, int* t2, int size) {
 }
 
 int* getIssuedEdgesLabels(Graph* g, Vertex* v) {
-    IssuedEdges* voisins = getIssuedEdges(g, v);
     int* res = calloc(g->nbv, sizeof(int));
-    Vertex temp;
-    int indice = 0;
-    for (int i = 0; i < voisins->size; i++) {
-        if (strcmp(voisins->issuedEdges[i]->vertices[0].name, v->name) == 0) {
-            temp = voisins->issuedEdges[i]->vertices[1];
-
-        } else {
-            temp = voisins->issuedEdges[i]->vertices[0];
-        }
-        for (int j = 0; j < g->nbv; j++) {
-            if (strcmp(g->vertices[j].name, temp.name) == 0) { indice = j; }
+    int* ends = malloc(2 * g->nbe * sizeof(int));
+    getEdgesEndpoints(g, ends);
+    // The vertices of the edges share the name pointer of the vertices of g
+    for (int i = 0; i < 2 * g->nbe; i++) {
+        if (ends[i] != -1 && ends[i ^ 1] != -1 && g->vertices[ends[i]].name == v->name) {
+            res[ends[i ^ 1]] = 1;
         }
-        res[indice] = 1;
     }
+    free(ends);
     return res;
 }
 
+int adjacencyRows(Graph* g, uint64_t* rows) {
+    if (g->nbv > SMALL_GRAPH_ORDER) { return 0; }
+    int* ends = malloc(2 * g->nbe * sizeof(int));
+    getEdgesEndpoints(g, ends);
+    memset(rows, 0, g->nbv * sizeof(uint64_t));
+    for (int i = 0; i < 2 * g->nbe; i++) {
+        if (ends[i] != -1 && ends[i ^ 1] != -1) { rows[ends[i]] |= 1ULL << ends[i ^ 1]; }
+    }
+    free(ends);
+    return 1;
+}
+
 int isConnected(Graph* g) {
+    uint64_t rows[SMALL_GRAPH_ORDER];
+    if (g->nbv > 0 && adjacencyRows(g, rows)) {
+        // Breadth-first search on bitsets, the frontier is reached but not explored yet
+        uint64_t reached = 1;
+        uint64_t frontier = 1;
+        while (frontier) {
+            int v = __builtin_ctzll(frontier);
+            frontier &= frontier - 1;
+            uint64_t found = rows[v] & ~reached;
+            reached |= found;
+            frontier |= found;
+        }
+        return reached == (g->nbv == 64 ? ~0ULL : (1ULL << g->nbv) - 1);
+    }
+
     int* curr = calloc(g->nbv, sizeof(int));
     curr[0] = 1;
     int* next = calloc(g->nbv, sizeof(int));
@@ -220,10 +303,13 @@ int isConnected(Graph* g) {
             }
         }
     } while (!tabEquals(curr, next, g->nbv, g->nbv));
+    int res = 1;
     for (int i = 0; i < g->nbv; i++) {
-        if (curr[i] == 0) { return 0; }
+        if (curr[i] == 0) { res = 0; }
     }
-    return 1;
+    free(curr);
+    free(next);
+    return res;
 }
 
 void printGraph(Graph* g) {
@@ -277,6 +363,7 @@ void relabelGraph(Graph* g) {
         permuteTab(seen, curr, lenseen - 1);
         lenseen--;
     }
+    free(seen);
 }
 void relabelEdgesGraph(Graph* g, int* labelsSommets, int taille) {
 
@@ -318,6 +405,7 @@ void relabelEdgesGraph(Graph* g, int* labelsSommets, int taille) {
         permuteTab(seen, curr, lenseen - 1);
         lenseen--;
     }
+    free(seen);
 }
 
 IssuedEdges* getIssuedEdges(Graph* g, Vertex* v) {
@@ -346,145 +434,148 @@ void freeIssuedEdges(IssuedEdges* v) {
 }
 
 int* degreesTab(Graph* g) {
-    int* tab = (int*)malloc(g->nbv * sizeof(int));
-    for (int i = 0; i < g->nbv; i++) {
-        tab[i] = (getIssuedEdges(g, &(g->vertices[i])))->size;
+    int* tab = (int*)calloc(g->nbv, sizeof(int));
+    int* ends = malloc(2 * g->nbe * sizeof(int));
+    getEdgesEndpoints(g, ends);
+    for (int i = 0; i < g->nbe; i++) {
+        tab[ends[2 * i]]++;
+        // A loop is issued once from its vertex
+        if (ends[2 * i + 1] != ends[2 * i]) { tab[ends[2 * i + 1]]++; }
     }
+    free(ends);
     return tab;
 }
 
-void smallestDegree(int* degres, int* tab, int taille) {
-    // Put the vertex with the smallest degree in first
-    int min = -1;
-    int indice_min = 0;
-    for (int i = 1; i < taille; i++) {
-        if (tab[i] != -1 && min < degres[tab[i]]) {
-            min = degres[tab[i]];
-            indice_min = i;
+// k degenerted algorithm but the vertices are ordered by their degrees
+int* degeneratedOrder(Graph* G) {
+    int nbv = G->nbv;
+    int nbe = G->nbe;
+    int* L = malloc((nbv + 1) * sizeof(int));
+    if (!nbv) { return L; }
+    int* degrees = degreesTab(G);
+    int* ends = malloc(2 * nbe * sizeof(int));
+    getEdgesEndpoints(G, ends);
+
+    // The neighbours of the vertex i are neighbours[offsets[i]] to neighbours[offsets[i+1]-1]
+    int* offsets = calloc(nbv + 1, sizeof(int));
+    int* neighbours = malloc(2 * nbe * sizeof(int));
+    for (int i = 0; i < 2 * nbe; i++) {
+        offsets[ends[i] + 1]++;
+    }
+    for (int i = 0; i < nbv; i++) {
+        offsets[i + 1] += offsets[i];
+    }
+    int* fill = malloc(nbv * sizeof(int));
+    memcpy(fill, offsets, nbv * sizeof(int));
+    for (int i = 0; i < 2 * nbe; i++) {
+        neighbours[fill[ends[i]]++] = ends[i ^ 1];
+    }
+
+    // The vertices are ranked by original degree, then by index, with a counting sort
+    int max = maxInTab(degrees, nbv);
+    int* start = calloc(max + 1, sizeof(int));
+    for (int i = 0; i < nbv; i++) {
+        start[degrees[i] + 1]++;
+    }
+    for (int d = 0; d < max; d++) {
+        start[d + 1] += start[d];
+    }
+    int* byRank = malloc(nbv * sizeof(int));
+    int* rank = malloc(nbv * sizeof(int));
+    int* next = malloc(max * sizeof(int));
+    memcpy(next, start, max * sizeof(int));
+    for (int i = 0; i < nbv; i++) {
+        rank[i] = next[degrees[i]]++;
+        byRank[rank[i]] = i;
+    }
+
+    // The bucket d holds the vertices of current degree d as a bitset of their ranks.
+    // Their original degree is at least d, so the bitset starts at the word of start[d]
+    int* firstWord = malloc(max * sizeof(int));
+    int* wordOffset = malloc((max + 1) * sizeof(int));
+    wordOffset[0] = 0;
+    for (int d = 0; d < max; d++) {
+        firstWord[d] = start[d] >> 6;
+        wordOffset[d + 1] = wordOffset[d] + ((nbv - 1) >> 6) - firstWord[d] + 1;
+    }
+    uint64_t* buckets = calloc(wordOffset[max], sizeof(uint64_t));
+    int* sizes = calloc(max, sizeof(int));
+    // The first word of each bucket that may be non zero
+    int* cursor = malloc(max * sizeof(int));
+    memcpy(cursor, firstWord, max * sizeof(int));
+    int* current = malloc(nbv * sizeof(int));
+    for (int i = 0; i < nbv; i++) {
+        current[i] = degrees[i];
+        int r = rank[i];
+        buckets[wordOffset[current[i]] + (r >> 6) - firstWord[current[i]]] |= 1ULL << (r & 63);
+        sizes[current[i]]++;
+    }
+
+    int d = 0;
+    for (int k = 0; k < nbv; k++) {
+        while (!sizes[d]) {
+            d++;
         }
-    }
-    int temp = tab[0];
-    tab[0] = tab[indice_min];
-    tab[indice_min] = temp;
-}
-
-int** initializeD(Graph* g, int maxm, int* baseDegrees) {
-    // Table D of degeneracy
-    int** D = malloc(maxm * sizeof(int*));
-    int* tab = degreesTab(g);
-    int cpt;
-    int check;
-    int check2 = 0;
-    int nbv = g->nbv;
-    if (!nbv) { check2 = 1; }
-
-    for (int i = 0; i < maxm; i++) {
-        cpt = 0;
-        D[i] = malloc((nbv + check2) * sizeof(int));
-
-        for (int j = 0; j < (nbv + check2); j++) {
-            // par defaut
-            check = 0;
-            D[i][j] = -1;
-            for (int k = cpt; k < nbv; k++) {
-
-                // We check if there is a vertex with this degree in the table
-                if (tab[k] == i) {
-
-                    D[i][j] = k;
-                    j++;
-                    cpt = k + 1;
-                    check = 1;
-                }
-            }
-
-            if (check) { j--; }
+        uint64_t* bucket = buckets + wordOffset[d] - firstWord[d];
+        while (!bucket[cursor[d]]) {
+            cursor[d]++;
         }
-        smallestDegree(baseDegrees, D[i], nbv);
-    }
-
-    return D;
-}
-
-int isD(int** D, int size) {
-    // check if D contains only -1
-    for (int i = 0; i < size; i++) {
-        if (D[i][0] != -1) { return 1; }
-    }
-    return 0;
-}
-
-int countInBetween(int* L, int size, int min, int max) {
-    // len([k for k in L && min<=k<=max])
-    int res = 0;
-    for (int i = 0; i < size; i++) {
-        if (min <= L[i] && L[i] <= max) { res++; }
-    }
-    return res;
+        int r = (cursor[d] << 6) + __builtin_ctzll(bucket[cursor[d]]);
+        bucket[r >> 6] &= ~(1ULL << (r & 63));
+        sizes[d]--;
+        int v = byRank[r];
+        L[k] = v;
+        current[v] = -1;
+
+        // The remaining neighbours lose an edge and go down one bucket
+        for (int t = offsets[v]; t < offsets[v + 1]; t++) {
+            int u = neighbours[t];
+            if (current[u] <= 0) { continue; }
+            int c = current[u]--;
+            int ru = rank[u];
+            buckets[wordOffset[c] + (ru >> 6) - firstWord[c]] &= ~(1ULL << (ru & 63));
+            sizes[c]--;
+            buckets[wordOffset[c - 1] + (ru >> 6) - firstWord[c - 1]] |= 1ULL << (ru & 63);
+            sizes[c - 1]++;
+            if ((ru >> 6) < cursor[c - 1]) { cursor[c - 1] = ru >> 6; }
+        }
+        if (d > 0) { d--; }
+    }
+
+    free(degrees);
+    free(ends);
+    free(offsets);
+    free(neighbours);
+    free(fill);
+    free(start);
+    free(next);
+    free(byRank);
+    free(rank);
+    free(firstWord);
+    free(wordOffset);
+    free(buckets);
+    free(sizes);
+    free(cursor);
+    free(current);
+    return L;
 }
 
-int clonedGraphIndex(int* L, int size, int D) {
+int countTriangle(Graph* g) {
     int res = 0;
-    int curr = D;
-    int prev = 0;
-    int temp = D;
-    int ecart = countInBetween(L, size, prev, curr);
-    while (ecart) {
-        curr += ecart;
-        prev = temp + 1;
-
-        temp = curr;
-        res += ecart;
-        ecart = countInBetween(L, size, prev, curr);
-    }
-    return D + res;
-}
-
-// k degenerted algorithm but the vertices are ordered by their degrees
-int* degeneratedOrder(Graph* G) {
-
-    // Since we are modifying the graph, we will clone it
-    Graph* g = cloneGraph(G);
-    int* baseTab = degreesTab(g);
-
-    int* L = malloc(g->nbv * sizeof(int));
-    for (int i = 0; i < g->nbv; i++) {
-        L[i] = g->nbv;
-    }
-    int k = 0;
-    int max = maxInTab(baseTab, g->nbv);
-    int** D = initializeD(g, max, baseTab);
-    int nbv = g->nbv;
-
-    while (isD(D, max)) {
-
-        for (int i = 0; i < max; i++) {
-            // The D tables are ordered with the interesting vertex in the
-            // beginning
-            if (D[i][0] != -1) {
-
-                // We retain the position of the vertex
-                L[k] = clonedGraphIndex(L, nbv, D[i][0]);
-
-                k++;
-
-                deleteVertex(g, g->vertices[D[i][0]]);
-
-                D = initializeD(g, max, baseTab);
-
-                break;
-            }
+    uint64_t rows[SMALL_GRAPH_ORDER];
+    if (adjacencyRows(g, rows)) {
+        // The common neighbours of the endpoints of each edge
+        int* ends = malloc(2 * g->nbe * sizeof(int));
+        getEdgesEndpoints(g, ends);
+        for (int i = 0; i < g->nbe; i++) {
+            res += __builtin_popcountll(rows[ends[2 * i]] & rows[ends[2 * i + 1]]);
         }
+        free(ends);
+        return res / 3;
     }
 
-    freeGraph(g);
-    return L;
-}
-
-int countTriangle(Graph* g) {
     Vertex v1;
     Vertex v2;
-    int res = 0;
     int* tab1;
     int* tab2;
 
@@ -497,6 +588,8 @@ int countTriangle(Graph* g) {
         for (int j = 0; j < g->nbv; j++) {
             res += tab1[j] * tab2[j];
         }
+        free(tab1);
+        free(tab2);
     }
     return (int)(res / 3);
 }
@@ -587,33 +680,92 @@ Graph* oddAntiprismVMT(char* name, int n) {
     return ap;
 }
 
-int sameLabeling(Graph* g1, Graph* g2) {
-    int n1 = g1->nbv;
-    int n2 = g2->nbv;
-    if (n1 != n2) { return 0; }
-    int* tab1 = malloc(n1 * sizeof(int));
-    for (int i = 0; i < n1; i++) {
-        tab1[i] = g1->vertices[i].label;
+/**
+ * Compares two edges of a canonical form, given as triples of labels
+ */
+int cmpTriple(const void* a, const void* b) {
+    const int* t1 = a;
+    const int* t2 = b;
+    for (int i = 0; i < 3; i++) {
+        if (t1[i] != t2[i]) { return t1[i] - t2[i]; }
     }
-    int* tab2 = malloc(n1 * sizeof(int));
-    for (int i = 0; i < n1; i++) {
-        tab2[i] = g2->vertices[i].label;
+    return 0;
+}
+
+void canonicalForm(Graph* g, int* form) {
+    int* ends = malloc(2 * g->nbe * sizeof(int));
+    getEdgesEndpoints(g, ends);
+    for (int i = 0; i < g->nbv; i++) {
+        form[i] = g->vertices[i].label;
     }
+    qsort(form, g->nbv, sizeof(int), cmp);
 
-    qsort(tab1, n1, sizeof(int), cmp);
-    qsort(tab2, n1, sizeof(int), cmp);
-    for (int i = 0; i < n1; i++) {
+    // With distinct vertex labels, an edge is known by the labels of its ends
+    int* triples = form + g->nbv;
+    for (int i = 0; i < g->nbe; i++) {
+        int l1 = g->vertices[ends[2 * i]].label;
+        int l2 = g->vertices[ends[2 * i + 1]].label;
+        triples[3 * i] = l1 < l2 ? l1 : l2;
+        triples[3 * i + 1] = l1 < l2 ? l2 : l1;
+        triples[3 * i + 2] = g->edges[i].label;
+    }
+    qsort(triples, g->nbe, 3 * sizeof(int), cmpTriple);
+    free(ends);
+}
 
-        if (tab1[i] != tab2[i]) {
+uint64_t hashLabeling(Graph* g) {
+    int size = g->nbv + 3 * g->nbe;
+    int nbl = g->nbv + g->nbe;
+    int* form = malloc(size * sizeof(int));
+    int* complement = malloc(size * sizeof(int));
+    canonicalForm(g, form);
+
+    // The complement k -> nbl+1-k reverses the order of the labels
+    for (int i = 0; i < g->nbv; i++) {
+        complement[i] = nbl + 1 - form[g->nbv - 1 - i];
+    }
+    for (int i = 0; i < g->nbe; i++) {
+        int* t = form + g->nbv + 3 * i;
+        int* c = complement + g->nbv + 3 * i;
+        c[0] = nbl + 1 - t[1];
+        c[1] = nbl + 1 - t[0];
+        c[2] = nbl + 1 - t[2];
+    }
+    qsort(complement + g->nbv, g->nbe, 3 * sizeof(int), cmpTriple);
 
-            free(tab1);
-            free(tab2);
-            return 0;
+    int* smallest = form;
+    for (int i = 0; i < size; i++) {
+        if (form[i] != complement[i]) {
+            if (complement[i] < form[i]) { smallest = complement; }
+            break;
         }
     }
-    free(tab1);
-    free(tab2);
-    return 1;
+
+    // FNV-1a, then a final mix so that the low bits are usable as an index
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < size; i++) {
+        h ^= (uint32_t)smallest[i];
+        h *= 0x100000001b3ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    free(form);
+    free(complement);
+    return h;
+}
+
+int sameLabeling(Graph* g1, Graph* g2) {
+    if (g1->nbv != g2->nbv || g1->nbe != g2->nbe) { return 0; }
+    int size = g1->nbv + 3 * g1->nbe;
+    int* form1 = malloc(size * sizeof(int));
+    int* form2 = malloc(size * sizeof(int));
+    canonicalForm(g1, form1);
+    canonicalForm(g2, form2);
+    int res = memcmp(form1, form2, size * sizeof(int)) == 0;
+    free(form1);
+    free(form2);
+    return res;
 }
 
 Graph *createCompleteGraph(int size){
@@ -635,3 +787,21 @@ Graph *createCompleteGraph(int size){
     return g;
 }
 
+Graph* oddCompleteVMT(int size) {
+    Graph* g = createCompleteGraph(size);
+    int half = (size + 1) / 2;
+    for (int i = 0; i < size; i++) {
+        g->vertices[i].label = 1 + (2 * i) % size;
+    }
+    // The edges of a same length (in the cyclic order given by 2^-1) have
+    // consecutive labels, one per vertex sum modulo size
+    int e = 0;
+    for (int i = 0; i < size - 1; i++) {
+        for (int j = i + 1; j < size; j++) {
+            int x = ((i - j + size) * half) % size;
+            int length = x < size - x ? x : size - x;
+            g->edges[e++].label = size + 1 + (i + j) % size + size * (length - 1);
+        }
+    }
+    return g;
+}
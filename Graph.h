@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdint.h>
+
 /**
  * A vertex has a name and a labeling
  * Use the createVertex function to properly create one
@@ -119,12 +121,35 @@ int addVertex(Graph* g, Vertex v);
 int addEdge(Graph* g, Edge e);
 
 /**
- * Clones the graph
+ * Clones the graph.
+ * The clone owns its names, so it can be freed independently of g.
  * @param g The graph to clone
  * @return A newly allocated graph with the same structure as g
  */
 Graph* cloneGraph(Graph* g);
 
+/**
+ * Finds the index of the endpoints of every edge, in O(n+m)
+ * @param g The graph we want to know about
+ * @param ends The table of size 2*nbe to fill. The endpoints of the edge i
+ * are stored in ends[2i] and ends[2i+1], -1 if the vertex is not in g
+ */
+void getEdgesEndpoints(Graph* g, int* ends);
+
+/**
+ * Copies the labels of the graph in a table
+ * @param g The graph we want to know about
+ * @param labels The table of size nbv+nbe to fill, vertices first then edges
+ */
+void getLabels(Graph* g, int* labels);
+
+/**
+ * Labels the graph with the values of a table
+ * @param g The graph to relabel
+ * @param labels The table of size nbv+nbe, vertices first then edges
+ */
+void setLabels(Graph* g, int* labels);
+
 /**
  * Removes an edge from the graph
  * @param g The graph we want to remove an edge from
@@ -170,6 +195,20 @@ void printIssuedEdges(IssuedEdges* n);
  */
 int* getIssuedEdgesLabels(Graph* g, Vertex* v);
 
+/**
+ * The largest order of the graphs whose adjacency fits in rows of 64 bits
+ */
+#define SMALL_GRAPH_ORDER 64
+
+/**
+ * Computes the adjacency rows of a small graph, the bit j of rows[i] is set
+ * if the vertices i and j are adjacent
+ * @param g The graph we want to know about
+ * @param rows The table of size g->nbv where the rows are stored
+ * @return 1 if the rows were computed, 0 if g has more than SMALL_GRAPH_ORDER vertices
+ */
+int adjacencyRows(Graph* g, uint64_t* rows);
+
 /**
  * @param g The graph we want to know about
  * @return 1 if the graph is connected, 0 if not
@@ -218,7 +257,8 @@ int* degreesTab(Graph* g);
 /**
  * Return the list of the indexes of the vertices, sorted with the degenareted order algorithm.
  * Its similar to the degenerated order algorithm that is presented here : https://en.wikipedia.org/wiki/Degeneracy_(graph_theory)
- * The only difference is, when it has to choose between multiple vertices, it takes the one with the minimal degree in the original graph
+ * The only difference is, when it has to choose between multiple vertices, it takes the one with the minimal degree in the original graph,
+ * then the one with the smallest index. It runs in O(n+m) with buckets of vertices by degree, without modifying the graph
  * @param G the graph
  * @return the table L in the algorithm
  */
@@ -249,7 +289,28 @@ Graph* createAntiprism(char* name, int n);
 Graph* oddAntiprismVMT(char* name, int n);
 
 /**
- * Checks if 2 graphs have the same labeling by isomorphism
+ * Computes a form of the labeling that does not depend on the names and order
+ * of the elements: the sorted labels of the vertices, followed by the sorted
+ * triples (lowest end label, highest end label, edge label).
+ * When the vertex labels are distinct, two labelings of a graph have the same
+ * form if and only if an automorphism of the graph maps one onto the other
+ * @param g The labeled graph
+ * @param form The table of size nbv+3*nbe to fill
+ */
+void canonicalForm(Graph* g, int* form);
+
+/**
+ * Hashes the labeling so that equivalent labelings have the same hash:
+ * the ones mapped onto each other by an automorphism of the graph, or by the
+ * complement of the labels k -> nbv+nbe+1-k
+ * @param g The labeled graph
+ * @return The hash of the smallest canonical form of the labeling and of its complement
+ */
+uint64_t hashLabeling(Graph* g);
+
+/**
+ * Checks if 2 graphs have the same labeling by isomorphism,
+ * by comparing their canonical forms
  * @param g1 The first graph to compare
  * @param g2 The second graph to compare
  * @return 1 if the labeling is the same, 0 if not
@@ -263,3 +324,11 @@ int sameLabeling(Graph* g1, Graph* g2);
  * @return g
  */
 Graph* createCompleteGraph(int size);
+
+/**
+ * Creates a complete graph of odd size with a VMT labeling, given by a closed
+ * formula. The vertices and edges are the same as in createCompleteGraph
+ * @param size The odd size of the complete graph
+ * @return The pointer to the complete graph with a VMT labeling
+ */
+Graph* oddCompleteVMT(int size);
@@ -20,54 +20,14 @@ GraphList* parseAllGraphs(char* filename) {
     GraphList* res = malloc(sizeof(GraphList));
     res->head = NULL;
 
-    char buff[BUFF_SIZE];
     CellGraph* currCell = res->head;
-    fgets(buff, BUFF_SIZE, f); // \n in normal condition
-
-    while (!feof(f)) {
-
-        int graphNum = 0;
-        int graphOrder = 0;
-        fscanf(f, "Graph %d, order %d.\n", &graphNum, &graphOrder);
-        // Graph %d, order %d in normal condition
-        Graph* g = malloc(sizeof(Graph));
-        g->name = malloc(100 * sizeof(char));
-        sprintf(buff, "%d-%d", graphNum, graphOrder);
-        strcpy(g->name, buff);
-
-        int nbv = 0;
-        int nbe = 0;
-        fscanf(f, "%d %d\n", &nbv, &nbe);
-        g->nbv = nbv;
-        g->nbvMAX = nbv;
-        g->nbe = nbe;
-        g->nbeMAX = (nbv * (nbv - 1)) / 2;
-
-        int cpt = 1;
-        g->vertices = (Vertex*)malloc(nbv * sizeof(Vertex));
-        for (int i = 0; i < nbv; i++) {
-            // Convert i value to char*
-            char* str = malloc(20 * sizeof(char));
-            sprintf(str, "v%d", i);
-            g->vertices[i] = createVertex(str, cpt);
-            cpt++;
-        }
-
-        g->edges = (Edge*)malloc(nbe * sizeof(Edge));
-
-        int v1;
-        int v2;
-        for (int i = 0; i < nbe; i++) {
-
-            fscanf(f, "%d %d  ", &v1, &v2);
-            // Convert v1 v2 value to char*
-            char* str = malloc(20 * sizeof(char));
-            sprintf(str, "e%d", i);
-
-            Vertex eff_v1 = g->vertices[v1];
-            Vertex eff_v2 = g->vertices[v2];
-            g->edges[i] = createEdge(str, cpt, eff_v1, eff_v2);
-            cpt++;
+    int capacity = BUFF_SIZE;
+    char* text = malloc(capacity);
+    while (readGraphText(f, &text, &capacity)) {
+        Graph* g = parseGraphText(text);
+        if (!g) {
+            fprintf(stderr, "Ignored a malformed graph of %s\n", filename);
+            continue;
         }
 
         if (!res->head) {
@@ -83,10 +43,67 @@ GraphList* parseAllGraphs(char* filename) {
             currCell = currCell->nxt;
         }
     }
+    free(text);
     fclose(f);
     return res;
 }
 
+int readGraphText(FILE* f, char** text, int* capacity) {
+    char line[BUFF_SIZE];
+    int size = 0;
+    while (fgets(line, BUFF_SIZE, f)) {
+        if (!size && strncmp(line, "Graph", 5) != 0) { continue; }
+        // An empty line ends the graph, a long line of edges is read in pieces
+        if (line[0] == '\n' && (*text)[size - 1] == '\n') { break; }
+        int length = strlen(line);
+        if (size + length + 1 > *capacity) {
+            *capacity = 2 * (size + length + 1);
+            *text = realloc(*text, *capacity);
+        }
+        memcpy(*text + size, line, length + 1);
+        size += length;
+    }
+    return size > 0;
+}
+
+Graph* parseGraphText(char* text) {
+    int graphNum = 0;
+    int graphOrder = 0;
+    int nbv = 0;
+    int nbe = 0;
+    int read = 0;
+    if (sscanf(text, "Graph %d, order %d. %d %d%n", &graphNum, &graphOrder, &nbv, &nbe,
+               &read) != 4) {
+        return NULL;
+    }
+    if (nbv < 0 || nbe < 0 || nbe > nbv * (nbv - 1) / 2) { return NULL; }
+    char* curr = text + read;
+    char name[BUFF_SIZE];
+    sprintf(name, "%d-%d", graphNum, graphOrder);
+    Graph* g = createGraph(name, nbv);
+
+    int cpt = 1;
+    for (int i = 0; i < nbv; i++) {
+        sprintf(name, "v%d", i);
+        addVertex(g, createVertex(name, cpt));
+        cpt++;
+    }
+    for (int i = 0; i < nbe; i++) {
+        char* start = curr;
+        int v1 = strtol(curr, &curr, 10);
+        int v2 = strtol(curr, &curr, 10);
+        // A missing end or a vertex out of the graph
+        if (curr == start || v1 < 0 || v1 >= nbv || v2 < 0 || v2 >= nbv) {
+            freeGraph(g);
+            return NULL;
+        }
+        sprintf(name, "e%d", i);
+        addEdge(g, createEdge(name, cpt, g->vertices[v1], g->vertices[v2]));
+        cpt++;
+    }
+    return g;
+}
+
 void freeFromCell(CellGraph* cg) {
     CellGraph* currCell = cg;
     while (currCell) {
@@ -97,6 +114,11 @@ void freeFromCell(CellGraph* cg) {
     }
 }
 
+void freeList(GraphList* l) {
+    freeFromCell(l->head);
+    free(l);
+}
+
 void generateDotFile(char* filename, Graph* g, int mode) {
 
     FILE* f = fopen(filename, "w");
@@ -1,6 +1,8 @@
 #pragma once
 #include "Graph.h"
 
+#include <stdio.h>
+
 /**
  * A cell for a linked list of graphs
  * This should not be created as is.
@@ -27,13 +29,32 @@ struct _GraphList {
  * The [nauty program](https://pallini.di.uniroma1.it/) can generate such files.
  * First generate a graph6 formated file using the geng binary,
  * then use the showg binary on the previously generated file, withe the option
- * -e.
+ * -e. The malformed graphs are skipped with a message on stderr.
  * @param filename The path of the formated file
  * @return A linked list of graphs. The GraphList structure just stores the
  * head.
  */
 GraphList* parseAllGraphs(char* filename);
 
+/**
+ * Reads the text of the next graph of a file in the format of parseAllGraphs,
+ * from its "Graph" line to the next empty line, without parsing it. The graphs
+ * of a large file can then be parsed on several threads
+ * @param f The file, opened for reading
+ * @param text The buffer where the text is stored, reallocated if needed
+ * @param capacity The size of the buffer, updated when it grows
+ * @return 1 if a graph was read, 0 at the end of the file
+ */
+int readGraphText(FILE* f, char** text, int* capacity);
+
+/**
+ * Parses a graph read by readGraphText
+ * @param text The text of the graph
+ * @return The graph, NULL if the text is not a graph, has too many edges or an
+ * edge with a vertex out of the graph
+ */
+Graph* parseGraphText(char* text);
+
 /**
  * Frees the cell provided and all the next ones
  * @param cg The CellGraph from wich we start freeing memory
@@ -0,0 +1,39 @@
+#include "HashSet.h"
+
+#include <stdlib.h>
+
+HashSet* createHashSet(int expected) {
+    // At most half full, so that the probe sequences stay short
+    uint64_t capacity = 64;
+    while (capacity < 2 * (uint64_t)expected) {
+        capacity *= 2;
+    }
+    HashSet* h = malloc(sizeof(HashSet));
+    h->keys = calloc(capacity, sizeof(uint64_t));
+    h->mask = capacity - 1;
+    h->size = 0;
+    return h;
+}
+
+void freeHashSet(HashSet* h) {
+    free(h->keys);
+    free(h);
+}
+
+int insertHashSet(HashSet* h, uint64_t key) {
+    // 0 marks the empty slots
+    if (key == 0) { key = 1; }
+    uint64_t i = key & h->mask;
+    while (1) {
+        uint64_t current = __atomic_load_n(&h->keys[i], __ATOMIC_ACQUIRE);
+        if (current == 0 &&
+            __atomic_compare_exchange_n(&h->keys[i], &current, key, 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            __atomic_fetch_add(&h->size, 1, __ATOMIC_RELAXED);
+            return 1;
+        }
+        // Either the slot was taken, or another thread just filled it
+        if (current == key) { return 0; }
+        i = (i + 1) & h->mask;
+    }
+}
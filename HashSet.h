@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * A set of 64 bits keys, with open addressing.
+ * Insertions are lock-free, so the set can be shared between threads.
+ * The table never grows, it is sized for the expected number of keys.
+ *
+ * Use the createHashSet function to properly create one
+ */
+typedef struct _hashSet {
+    uint64_t* keys;
+    uint64_t mask;
+    int size;
+} HashSet;
+
+/**
+ * Allocates an empty set
+ * @param expected The maximum number of keys that will be inserted
+ * @return The pointer to the allocated set
+ */
+HashSet* createHashSet(int expected);
+
+/**
+ * Frees the memory of the set
+ * @param h The set to free
+ */
+void freeHashSet(HashSet* h);
+
+/**
+ * Adds a key to the set, if it is not already in it
+ * @param h The set to insert in
+ * @param key The key to insert, it should already be well mixed
+ * @return 1 if the key is new, 0 if it was already in the set
+ */
+int insertHashSet(HashSet* h, uint64_t key);
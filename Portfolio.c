@@ -0,0 +1,346 @@
+#include "Portfolio.h"
+#include "Utils.h"
+
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern int timeout;
+
+// The number of steps without improvement before a worker looks at the snapshot
+#define ADOPT_PERIOD 20
+// The annealing temperature is multiplied by COOLING after each sweep
+#define COOLING 0.95f
+#define COLDEST 0.05f
+
+const char* strategyNames[PORTFOLIO_STRATEGIES] = {"cascade", "simulated annealing",
+                                                   "tabu search", "iterated local search"};
+
+/**
+ * The best labels found so far, behind a sequence lock: the sequence is odd
+ * while a worker writes the labels, and a reader copies them again if the
+ * sequence changed during its copy
+ */
+typedef struct _snapshot {
+    unsigned int sequence;
+    long value;
+    int* labels;
+    int nbl;
+} Snapshot;
+
+typedef struct _portfolio Portfolio;
+
+typedef struct _worker {
+    Portfolio* p;
+    int index;
+    int strategy;
+    Solver* s;
+    unsigned int seed;
+    long value;
+    long best;
+    // Annealing
+    float temperature;
+    // Tabu search, the step until which each element cannot be swapped
+    int* tabuUntil;
+    int steps;
+    int published;
+    int adopted;
+} Worker;
+
+struct _portfolio {
+    int method;
+    int k;
+    int l;
+    int d_k;
+    int d_l;
+    int* tabooPermutations;
+    int sizePT;
+    // The elements whose label can be swapped
+    int* movable;
+    int nbMovable;
+    float hottest;
+    Snapshot snapshot;
+    int stop;
+    int winner;
+};
+
+/**
+ * Replaces the labels of the snapshot if they are better
+ * @return 1 if the snapshot was replaced, 0 if not
+ */
+int publishSnapshot(Snapshot* snap, int* labels, long value) {
+    unsigned int sequence = __atomic_load_n(&snap->sequence, __ATOMIC_RELAXED);
+    do {
+        // Another worker is writing
+        while (sequence & 1) {
+            sequence = __atomic_load_n(&snap->sequence, __ATOMIC_RELAXED);
+        }
+    } while (!__atomic_compare_exchange_n(&snap->sequence, &sequence, sequence + 1, 0,
+                                          __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    int better = value < snap->value;
+    if (better) {
+        for (int i = 0; i < snap->nbl; i++) {
+            __atomic_store_n(&snap->labels[i], labels[i], __ATOMIC_RELAXED);
+        }
+        __atomic_store_n(&snap->value, value, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&snap->sequence, sequence + 2, __ATOMIC_RELEASE);
+    return better;
+}
+
+/**
+ * Copies the labels of the snapshot
+ * @return The value of the copied labels
+ */
+long readSnapshot(Snapshot* snap, int* labels) {
+    while (1) {
+        unsigned int sequence = __atomic_load_n(&snap->sequence, __ATOMIC_ACQUIRE);
+        if (sequence & 1) { continue; }
+        for (int i = 0; i < snap->nbl; i++) {
+            labels[i] = __atomic_load_n(&snap->labels[i], __ATOMIC_RELAXED);
+        }
+        long value = __atomic_load_n(&snap->value, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&snap->sequence, __ATOMIC_RELAXED) == sequence) { return value; }
+    }
+}
+
+long snapshotValue(Snapshot* snap) { return __atomic_load_n(&snap->value, __ATOMIC_RELAXED); }
+
+long workerObjective(Worker* w) {
+    Portfolio* p = w->p;
+    return objective(p->method, w->s, p->k, p->l, p->d_k, p->d_l);
+}
+
+/**
+ * One sweep of random swaps, accepted with the Metropolis rule
+ */
+void annealingStep(Worker* w) {
+    Portfolio* p = w->p;
+    Solver* s = w->s;
+    for (int move = 0; move < p->nbMovable; move++) {
+        int a = p->movable[rand_r(&w->seed) % p->nbMovable];
+        int b = p->movable[rand_r(&w->seed) % p->nbMovable];
+        if (a == b) { continue; }
+        swapLabels(s, a, b);
+        long value = workerObjective(w);
+        if (value <= w->value ||
+            (float)rand_r(&w->seed) / RAND_MAX < expf((float)(w->value - value) / w->temperature)) {
+            w->value = value;
+            if (value <= 0) { return; }
+        } else {
+            swapLabels(s, a, b);
+        }
+    }
+    w->temperature *= COOLING;
+    if (w->temperature < COLDEST) {
+        w->temperature = p->hottest;
+        memcpy(s->labels, s->bestLabels, (s->nbv + s->nbe) * sizeof(int));
+        indexLabels(s);
+        w->value = w->best;
+    }
+}
+
+/**
+ * Applies the best swap of a sample that is not tabu, or that gives the best
+ * labels of the worker so far
+ */
+void tabuStep(Worker* w) {
+    Portfolio* p = w->p;
+    Solver* s = w->s;
+    int tenure = 7 + p->nbMovable / 10;
+    int bestA = -1;
+    int bestB = -1;
+    long bestValue = 0;
+    for (int i = 0; i < p->nbMovable; i++) {
+        int a = p->movable[rand_r(&w->seed) % p->nbMovable];
+        int b = p->movable[rand_r(&w->seed) % p->nbMovable];
+        if (a == b) { continue; }
+        permuteTab(s->labels, a, b);
+        long value = workerObjective(w);
+        permuteTab(s->labels, a, b);
+        int tabu = w->tabuUntil[a] > w->steps || w->tabuUntil[b] > w->steps;
+        if (tabu && value >= w->best) { continue; }
+        if (bestA == -1 || value < bestValue) {
+            bestA = a;
+            bestB = b;
+            bestValue = value;
+        }
+    }
+    if (bestA == -1) { return; }
+    swapLabels(s, bestA, bestB);
+    w->value = bestValue;
+    w->tabuUntil[bestA] = w->steps + tenure + rand_r(&w->seed) % (tenure + 1);
+    w->tabuUntil[bestB] = w->tabuUntil[bestA];
+}
+
+/**
+ * Kicks the best labels of the worker, then applies the cascade until a local optimum
+ * @param stagnation The number of steps without improvement, for the strength of the kick
+ */
+void ilsStep(Worker* w, int stagnation) {
+    Portfolio* p = w->p;
+    Solver* s = w->s;
+    int strength = 1 + stagnation / 10;
+    if (strength > p->nbMovable / 2) { strength = 1; }
+    memcpy(s->labels, s->bestLabels, (s->nbv + s->nbe) * sizeof(int));
+    indexLabels(s);
+    perturbSolver(s, strength, p->tabooPermutations, p->sizePT);
+    w->value = localSearch(p->method, s, p->k, p->l, p->d_k, p->d_l, 0,
+                           p->tabooPermutations, p->sizePT);
+}
+
+void* portfolioWorker(void* arg) {
+    Worker* w = (Worker*)arg;
+    Portfolio* p = w->p;
+    Solver* s = w->s;
+    int nbl = s->nbv + s->nbe;
+    w->value = workerObjective(w);
+    w->best = w->value;
+    memcpy(s->bestLabels, s->labels, nbl * sizeof(int));
+    w->published += publishSnapshot(&p->snapshot, s->labels, w->value);
+
+    int stagnation = 0;
+    while (w->best > 0 && w->steps < timeout) {
+        if (__atomic_load_n(&p->stop, __ATOMIC_ACQUIRE)) { return NULL; }
+        switch (w->strategy) {
+        case PORTFOLIO_CASCADE:
+            cascadeStep(p->method, s, p->k, p->l, p->d_k, p->d_l, 0,
+                        p->tabooPermutations, p->sizePT);
+            w->value = workerObjective(w);
+            break;
+        case PORTFOLIO_ANNEALING:
+            annealingStep(w);
+            break;
+        case PORTFOLIO_TABU:
+            tabuStep(w);
+            break;
+        case PORTFOLIO_ILS:
+            ilsStep(w, stagnation);
+            break;
+        }
+        w->steps++;
+
+        if (w->value < w->best) {
+            w->best = w->value;
+            memcpy(s->bestLabels, s->labels, nbl * sizeof(int));
+            w->published += publishSnapshot(&p->snapshot, s->labels, w->value);
+            stagnation = 0;
+            continue;
+        }
+        stagnation++;
+        if (stagnation % ADOPT_PERIOD == 0 && snapshotValue(&p->snapshot) < w->best) {
+            w->best = readSnapshot(&p->snapshot, s->bestLabels);
+            memcpy(s->labels, s->bestLabels, nbl * sizeof(int));
+            indexLabels(s);
+            w->value = w->best;
+            w->adopted++;
+            stagnation = 0;
+        }
+    }
+    if (w->best <= 0) {
+        int none = -1;
+        __atomic_compare_exchange_n(&p->winner, &none, w->index, 0,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+        __atomic_store_n(&p->stop, 1, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+Solver* attemptSolvePortfolio(int method, Solver* s, int k, int l, int d_k, int d_l,
+                              int nbWorkers, int* tabooPermutations, int sizePT) {
+    int nbl = s->nbv + s->nbe;
+    if (nbWorkers < PORTFOLIO_STRATEGIES) { nbWorkers = PORTFOLIO_STRATEGIES; }
+    printf("Attempting portfolio for %s with %d workers\n", s->g->name, nbWorkers);
+
+    Portfolio p;
+    p.method = method;
+    p.k = k;
+    p.l = l;
+    p.d_k = d_k;
+    p.d_l = d_l;
+    p.tabooPermutations = tabooPermutations;
+    p.sizePT = sizePT;
+    p.stop = 0;
+    p.winner = -1;
+    p.movable = malloc(nbl * sizeof(int));
+    p.nbMovable = 0;
+    for (int i = 0; i < nbl; i++) {
+        if (!inTab(s->labels[i], tabooPermutations, sizePT)) { p.movable[p.nbMovable++] = i; }
+    }
+    p.hottest = nbl / 2.f > 1 ? nbl / 2.f : 1;
+    p.snapshot.sequence = 0;
+    p.snapshot.value = LONG_MAX;
+    p.snapshot.nbl = nbl;
+    p.snapshot.labels = malloc(nbl * sizeof(int));
+    memcpy(p.snapshot.labels, s->labels, nbl * sizeof(int));
+
+    Worker* workers = malloc(nbWorkers * sizeof(Worker));
+    pthread_t threads[nbWorkers];
+    for (int i = 0; i < nbWorkers; i++) {
+        Worker* w = workers + i;
+        w->p = &p;
+        w->index = i;
+        w->strategy = i % PORTFOLIO_STRATEGIES;
+        w->seed = rand();
+        w->temperature = p.hottest;
+        w->tabuUntil = calloc(nbl, sizeof(int));
+        w->steps = 0;
+        w->published = 0;
+        w->adopted = 0;
+        w->s = shareSolver(s);
+        if (i > 0) { perturbSolver(w->s, nbl, tabooPermutations, sizePT); }
+    }
+    // The first worker starts from the labels of s, which may already be a solution
+    // even when less than two labels can move
+    if (workerObjective(&workers[0]) <= 0) {
+        p.winner = 0;
+        memcpy(workers[0].s->bestLabels, workers[0].s->labels, nbl * sizeof(int));
+    } else if (p.nbMovable >= 2) {
+        for (int i = 0; i < nbWorkers; i++) {
+            pthread_create(&threads[i], NULL, portfolioWorker, workers + i);
+        }
+        for (int i = 0; i < nbWorkers; i++) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    int winner = p.winner;
+    if (winner != -1) {
+        memcpy(s->labels, workers[winner].s->bestLabels, nbl * sizeof(int));
+    } else if (p.snapshot.value < LONG_MAX) {
+        memcpy(s->labels, p.snapshot.labels, nbl * sizeof(int));
+    }
+    indexLabels(s);
+    writeSolver(s);
+    printDetails(winner == -1, method, s->g, k, l, d_k, d_l, 0);
+    if (winner != -1) {
+        printf("Solved by the %s of worker %d after %d steps\n",
+               strategyNames[workers[winner].strategy], winner, workers[winner].steps);
+    }
+    for (int strategy = 0; strategy < PORTFOLIO_STRATEGIES; strategy++) {
+        int steps = 0;
+        int published = 0;
+        int adopted = 0;
+        for (int i = strategy; i < nbWorkers; i += PORTFOLIO_STRATEGIES) {
+            steps += workers[i].steps;
+            published += workers[i].published;
+            adopted += workers[i].adopted;
+        }
+        printf("%s: %d steps, %d improvements of the shared labels, %d restarts from them\n",
+               strategyNames[strategy], steps, published, adopted);
+    }
+
+    for (int i = 0; i < nbWorkers; i++) {
+        free(workers[i].tabuUntil);
+        freeSolver(workers[i].s, 0);
+    }
+    free(workers);
+    free(p.snapshot.labels);
+    free(p.movable);
+    return winner == -1 ? NULL : s;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Solver.h"
+
+/**
+ * The strategies of the portfolio, the workers are given them in this order
+ */
+#define PORTFOLIO_CASCADE 0
+#define PORTFOLIO_ANNEALING 1
+#define PORTFOLIO_TABU 2
+#define PORTFOLIO_ILS 3
+#define PORTFOLIO_STRATEGIES 4
+
+/**
+ * Portfolio of strategies: each worker runs one of the strategies on its own
+ * thread and its own copy of the labels
+ * - the cascade of attemptSolveWithSolver
+ * - simulated annealing, with random swaps accepted with the Metropolis rule
+ * at a decreasing temperature, reheated from its best labels once cold
+ * - tabu search, the best of a sample of swaps is applied even if it is worse,
+ * then the swapped elements cannot be swapped again for a while
+ * - iterated local search, see attemptSolveIls
+ *
+ * The best labels found by any worker are shared in a snapshot. A worker that
+ * stagnates starts again from the snapshot if it is better than its own best
+ * labels. The first worker to solve the graph stops all the others, and the
+ * strategy that won is printed, with how often each strategy improved the
+ * snapshot.
+ *
+ * @param 	method the objective, see attemptSolveWithSolver
+ * @param 	s the solver, the first worker starts from its current labels and the
+ * others from random permutations of them. The best labels found are copied in it
+ * @param 	k Depends on the method, can be ignored
+ * @param 	l Depends on the method, can be ignored
+ * @param 	d_k Depends on the method, can be ignored
+ * @param 	d_l Depends on the method, can be ignored
+ * @param 	nbWorkers the number of threads, at least one per strategy is used
+ * @param 	tabooPermutations List of label that will not be permuted, NULL if ignored
+ * @param 	sizePT The size of the provided list, 0 if ignored
+ * @return 	s if a worker solved the graph in at most timeout steps, NULL if not
+ */
+Solver* attemptSolvePortfolio(int method, Solver* s, int k, int l, int d_k, int d_l,
+                              int nbWorkers, int* tabooPermutations, int sizePT);
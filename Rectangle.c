@@ -9,10 +9,8 @@
 #define BUFFER_SIZE 256
 
 Rectangle* createRectangle(char* name, int width, int height) {
-    int** newTable = malloc(height * sizeof(int*));
-    for (int i = 0; i < height; i++) {
-        newTable[i] = malloc(width * sizeof(int));
-    }
+    int* newTable = malloc(height * width * sizeof(int));
+    int* cellToEdge = malloc(height * width * sizeof(int));
     char buff[BUFFER_SIZE];
     sprintf(buff, "RECTANGLE_%s", name);
     Graph* g = createGraph(buff, height + width);
@@ -38,13 +36,15 @@ Rectangle* createRectangle(char* name, int width, int height) {
             Vertex vj = g->vertices[height + j];
 
             addEdge(g, createEdge(buff, cpt, vi, vj));
-            newTable[i][j] = cpt;
+            newTable[i * width + j] = cpt;
+            cellToEdge[i * width + j] = cpt - 1;
             cpt++;
         }
     }
 
     Rectangle* res = malloc(sizeof(Rectangle));
     res->table = newTable;
+    res->cellToEdge = cellToEdge;
     res->height = height;
     res->width = width;
     res->g = g;
@@ -53,55 +53,20 @@ Rectangle* createRectangle(char* name, int width, int height) {
 
 void freeRectangle(Rectangle* r) {
     freeGraph(r->g);
-    for (int i = 0; i < r->height; i++) {
-        free(r->table[i]);
-    }
     free(r->table);
+    free(r->cellToEdge);
     free(r);
 }
 
 Rectangle* updateRectangle(Rectangle* r) {
     /* Updates the table if the graph has been modified */
-    for (int i = 0; i < r->g->nbe; i++) {
-
-        int x = -1;
-        int y = -1;
-
-        Edge e = r->g->edges[i];
-
-        int xIsWidth = 2;
-        int yIsWidth = 2;
-
-        sscanf(e.vertices[0].name, "v%d,%d", &xIsWidth, &x);
-        sscanf(e.vertices[1].name, "v%d,%d", &yIsWidth, &y);
-
-        if (abs(xIsWidth) > 1 || abs(yIsWidth) > 1 || x == -1 || y == -1) {
-            fprintf(stderr,
-                    "Something went wrong when updating the rectangle %s, was "
-                    "it correctly generated ?\n",
-                    r->g->name);
-            exit(EXIT_FAILURE);
-        }
-
-        if (xIsWidth) {
-
-            if (yIsWidth || x >= r->width || y >= r->height) {
-                fprintf(stderr, "Provided rectangle %s, is NOT a rectangle\n",
-                        r->g->name);
-                exit(EXIT_FAILURE);
-            }
-
-            r->table[y][x] = e.label;
-        }
-
-        else {
-            if (!yIsWidth || x >= r->height || y >= r->width) {
-                fprintf(stderr, "Provided rectangle %s, is NOT a rectangle\n",
-                        r->g->name);
-                exit(EXIT_FAILURE);
-            }
-            r->table[x][y] = e.label;
-        }
+    if (r->g->nbe != r->height * r->width) {
+        fprintf(stderr, "Provided rectangle %s, is NOT a rectangle\n",
+                r->g->name);
+        exit(EXIT_FAILURE);
+    }
+    for (int c = 0; c < r->height * r->width; c++) {
+        r->table[c] = r->g->edges[r->cellToEdge[c]].label;
     }
     return r;
 }
@@ -109,11 +74,12 @@ Rectangle* updateRectangle(Rectangle* r) {
 void printRectangle(Rectangle* r, int update) {
     if (update) updateRectangle(r);
     for (int i = 0; i < r->height; i++) {
+        int* line = r->table + i * r->width;
         printf("[");
         for (int j = 0; j < r->width - 1; j++) {
-            printf("%3d, ", r->table[i][j]);
+            printf("%3d, ", line[j]);
         }
-        printf("%3d]\n", r->table[i][r->width - 1]);
+        printf("%3d]\n", line[r->width - 1]);
     }
 }
 
@@ -122,20 +88,158 @@ int getVal(Rectangle* r, int i, int j) {
         fprintf(stderr, "Index out of bounds\n");
         exit(EXIT_FAILURE);
     }
-    return r->table[i][j];
+    return r->table[i * r->width + j];
 }
 
 int* getLine(Rectangle* r, int i) {
 
     int* res = malloc(r->width * sizeof(int));
-    memcpy(res, r->table[i], r->width * sizeof(int));
+    memcpy(res, r->table + i * r->width, r->width * sizeof(int));
     return res;
 }
 
 int* getColumn(Rectangle* r, int j) {
     int* res = malloc(r->height * sizeof(int));
     for (int i = 0; i < r->height; i++) {
-        res[i] = r->table[i][j];
+        res[i] = r->table[i * r->width + j];
+    }
+    return res;
+}
+
+/**
+ * Checks that the table holds 1 to height*width, with the same sum on every
+ * line and the same sum on every column
+ */
+int isMagicTable(int* t, int height, int width) {
+    int nbc = height * width;
+    char* seen = calloc(nbc + 1, sizeof(char));
+    int res = 1;
+    for (int c = 0; c < nbc && res; c++) {
+        if (t[c] < 1 || t[c] > nbc || seen[t[c]]) { res = 0; }
+        else seen[t[c]] = 1;
+    }
+    free(seen);
+    long lineGoal = (long)nbc * (nbc + 1) / 2 / height;
+    long columnGoal = (long)nbc * (nbc + 1) / 2 / width;
+    for (int i = 0; i < height && res; i++) {
+        long sum = 0;
+        for (int j = 0; j < width; j++) {
+            sum += t[i * width + j];
+        }
+        if (sum != lineGoal) { res = 0; }
+    }
+    for (int j = 0; j < width && res; j++) {
+        long sum = 0;
+        for (int i = 0; i < height; i++) {
+            sum += t[i * width + j];
+        }
+        if (sum != columnGoal) { res = 0; }
     }
     return res;
 }
+
+/**
+ * Both sides multiple of 4: the values are written in order, and complemented
+ * on two cells of every 4 of each line and column
+ */
+void doublyEvenMagicRectangle(int* t, int height, int width) {
+    int nbc = height * width;
+    for (int i = 0; i < height; i++) {
+        for (int j = 0; j < width; j++) {
+            int v = i * width + j + 1;
+            int complement = (i % 4 == j % 4) || (i % 4 + j % 4 == 3);
+            t[i * width + j] = complement ? nbc + 1 - v : v;
+        }
+    }
+}
+
+/**
+ * Odd squares, with the Siamese method: the values go up and right, and down
+ * when the cell is already taken
+ */
+void siameseMagicSquare(int* t, int n) {
+    memset(t, 0, n * n * sizeof(int));
+    int i = 0;
+    int j = n / 2;
+    for (int v = 1; v <= n * n; v++) {
+        t[i * n + j] = v;
+        int ni = (i + n - 1) % n;
+        int nj = (j + 1) % n;
+        if (t[ni * n + nj]) {
+            ni = (i + 1) % n;
+            nj = j;
+        }
+        i = ni;
+        j = nj;
+    }
+}
+
+/**
+ * Two lines and an even width: the column j holds j+1 and 2*width-j, and the
+ * columns where the highest value goes up are chosen so that both lines
+ * have the same sum
+ */
+void twoLinesMagicRectangle(int* t, int width) {
+    if (width <= 0) { return; }
+    // Raising the column j adds 2*width-1-2j to the first line. We need k
+    // columns adding width*width/2, starting from the k columns adding the least
+    long goal = (long)width * width / 2;
+    int k = 0;
+    while (k < width && (long)k * (2 * width - k) < goal) {
+        k++;
+    }
+    if (k % 2) { k++; }
+    long extra = goal - (long)k * k;
+    int* raised = calloc(width, sizeof(int));
+    // The k raised columns are chosen among the last ones, so each rank moves
+    // the k chosen ones towards the first columns
+    for (int i = k - 1; i >= 0; i--) {
+        long moves = extra / 2;
+        if (moves > width - k) { moves = width - k; }
+        raised[width - 1 - i - moves] = 1;
+        extra -= 2 * moves;
+    }
+    for (int j = 0; j < width; j++) {
+        t[j] = raised[j] ? 2 * width - j : j + 1;
+        t[width + j] = raised[j] ? j + 1 : 2 * width - j;
+    }
+    free(raised);
+}
+
+int constructMagicRectangle(Rectangle* r) {
+    int height = r->height;
+    int width = r->width;
+    int nbc = height * width;
+    int* t = malloc(nbc * sizeof(int));
+    int built = 1;
+    if (height % 4 == 0 && width % 4 == 0) {
+        doublyEvenMagicRectangle(t, height, width);
+    } else if (height == width && height % 2 == 1) {
+        siameseMagicSquare(t, height);
+    } else if (height == 2 && width % 2 == 0 && width >= 4) {
+        twoLinesMagicRectangle(t, width);
+    } else if (width == 2 && height % 2 == 0 && height >= 4) {
+        // Transposed two lines rectangle
+        int* lines = malloc(nbc * sizeof(int));
+        twoLinesMagicRectangle(lines, height);
+        for (int i = 0; i < height; i++) {
+            t[i * 2] = lines[i];
+            t[i * 2 + 1] = lines[height + i];
+        }
+        free(lines);
+    } else {
+        built = 0;
+    }
+
+    // A construction is only used if it is really magic
+    if (built && isMagicTable(t, height, width)) {
+        memcpy(r->table, t, nbc * sizeof(int));
+        for (int c = 0; c < nbc; c++) {
+            r->g->edges[r->cellToEdge[c]].label = t[c];
+        }
+    } else {
+        built = 0;
+    }
+    free(t);
+    return built;
+}
@@ -11,7 +11,10 @@ typedef struct _Rectangle Rectangle;
 struct _Rectangle {
     int height;
     int width;
-    int** table;
+    // The value of the cell (i, j) is table[i * width + j]
+    int* table;
+    // The cell c is the label of the edge cellToEdge[c] of g
+    int* cellToEdge;
     Graph* g;
 };
 
@@ -31,7 +34,7 @@ Rectangle* createRectangle(char* name, int width, int height);
 void freeRectangle(Rectangle* r);
 
 /**
- * Updates the rectangle according to the labeling of the related graph
+ * Updates the rectangle according to the labeling of the related graph, in O(width*height)
  * @param r The rectangle to update
  * @return The pointer to the rectangle r if it succeed, NULL if it fails.
  */
@@ -49,7 +52,7 @@ void printRectangle(Rectangle* r, int update);
  * @param r The rectangle we want to retrieve the value from
  * @param i The line coordinate, starting from 0
  * @param j The column coordinate, starting from 0
- * @return The value is r->tab[i][j], exits program if out of bounds.
+ * @return The value is r->table[i * width + j], exits program if out of bounds.
  */
 int getVal(Rectangle* r, int i, int j);
 
@@ -68,3 +71,12 @@ int* getLine(Rectangle* r, int i);
  * @return A newly allocated list containing the values of the column j
  */
 int* getColumn(Rectangle* r, int j);
+
+/**
+ * Labels the rectangle with a magic rectangle from a known construction:
+ * both sides multiple of 4, odd squares, or two lines (or columns) of even length.
+ * The construction is checked before being used
+ * @param r The rectangle to label
+ * @return 1 if the rectangle was labelled, 0 if no construction is known for its size
+ */
+int constructMagicRectangle(Rectangle* r);
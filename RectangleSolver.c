@@ -0,0 +1,174 @@
+#include "RectangleSolver.h"
+#include "Solver.h"
+#include "Utils.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+extern int timeout;
+
+RectangleSolver* createRectangleSolver(Rectangle* r, int k, int l, int d_k, int d_l) {
+    RectangleSolver* rs = malloc(sizeof(RectangleSolver));
+    int height = r->height;
+    int width = r->width;
+    rs->r = r;
+    rs->height = height;
+    rs->width = width;
+    rs->k = k;
+    rs->l = l;
+    rs->d_k = d_k;
+    rs->d_l = d_l;
+    rs->cells = malloc(height * width * sizeof(int));
+    rs->lineSums = calloc(height, sizeof(int));
+    rs->columnSums = calloc(width, sizeof(int));
+    rs->lineGoals = malloc(height * sizeof(int));
+    rs->columnGoals = malloc(width * sizeof(int));
+    rs->lineOrder = malloc(height * sizeof(int));
+    rs->columnOrder = malloc(width * sizeof(int));
+
+    for (int i = 0; i < height * width; i++) {
+        rs->cells[i] = r->g->edges[r->cellToEdge[i]].label;
+        rs->lineSums[i / width] += rs->cells[i];
+        rs->columnSums[i % width] += rs->cells[i];
+    }
+    for (int i = 0; i < height; i++) {
+        rs->lineOrder[i] = i;
+    }
+    for (int j = 0; j < width; j++) {
+        rs->columnOrder[j] = j;
+    }
+    return rs;
+}
+
+void freeRectangleSolver(RectangleSolver* rs) {
+    free(rs->cells);
+    free(rs->lineSums);
+    free(rs->columnSums);
+    free(rs->lineGoals);
+    free(rs->columnGoals);
+    free(rs->lineOrder);
+    free(rs->columnOrder);
+    free(rs);
+}
+
+void writeRectangleSolver(RectangleSolver* rs) {
+    for (int i = 0; i < rs->height * rs->width; i++) {
+        rs->r->g->edges[rs->r->cellToEdge[i]].label = rs->cells[i];
+    }
+}
+
+/**
+ * Matches the weights with the goal weights c, c+d, ..., c+(size-1)d, the
+ * lowest weight with the lowest goal.
+ * The order is sorted by insertion, since it barely changes between two sweeps
+ * @return The distance between the weights and their goals
+ */
+long matchGoals(int* sums, int* order, int* goals, int size, int c, int d) {
+    for (int i = 1; i < size; i++) {
+        int current = order[i];
+        int j = i - 1;
+        while (j >= 0 && sums[order[j]] > sums[current]) {
+            order[j + 1] = order[j];
+            j--;
+        }
+        order[j + 1] = current;
+    }
+    long res = 0;
+    for (int i = 0; i < size; i++) {
+        int goal = d >= 0 ? c + i * d : c + (size - 1 - i) * d;
+        goals[order[i]] = goal;
+        res += abs(sums[order[i]] - goal);
+    }
+    return res;
+}
+
+/**
+ * Matches the lines and columns with their goals and updates the value of the solver
+ */
+void matchRectangleGoals(RectangleSolver* rs) {
+    rs->value = matchGoals(rs->lineSums, rs->lineOrder, rs->lineGoals, rs->height,
+                           rs->k, rs->d_k) +
+                matchGoals(rs->columnSums, rs->columnOrder, rs->columnGoals,
+                           rs->width, rs->l, rs->d_l);
+}
+
+/**
+ * @return The change of the distance to the goals if the cells a and b are swapped
+ */
+long swapDelta(RectangleSolver* rs, int a, int b) {
+    int delta = rs->cells[b] - rs->cells[a];
+    long res = 0;
+    int la = a / rs->width;
+    int lb = b / rs->width;
+    if (la != lb) {
+        res += abs(rs->lineSums[la] + delta - rs->lineGoals[la]) -
+               abs(rs->lineSums[la] - rs->lineGoals[la]);
+        res += abs(rs->lineSums[lb] - delta - rs->lineGoals[lb]) -
+               abs(rs->lineSums[lb] - rs->lineGoals[lb]);
+    }
+    int ca = a % rs->width;
+    int cb = b % rs->width;
+    if (ca != cb) {
+        res += abs(rs->columnSums[ca] + delta - rs->columnGoals[ca]) -
+               abs(rs->columnSums[ca] - rs->columnGoals[ca]);
+        res += abs(rs->columnSums[cb] - delta - rs->columnGoals[cb]) -
+               abs(rs->columnSums[cb] - rs->columnGoals[cb]);
+    }
+    return res;
+}
+
+void swapCells(RectangleSolver* rs, int a, int b) {
+    int delta = rs->cells[b] - rs->cells[a];
+    rs->lineSums[a / rs->width] += delta;
+    rs->lineSums[b / rs->width] -= delta;
+    rs->columnSums[a % rs->width] += delta;
+    rs->columnSums[b % rs->width] -= delta;
+    permuteTab(rs->cells, a, b);
+}
+
+/**
+ * Applies every swap of two cells that does not raise the distance to the goals
+ * @return 1 if the distance was lowered, 0 if not
+ */
+int sweepRectangle(RectangleSolver* rs) {
+    int nbc = rs->height * rs->width;
+    int improved = 0;
+    for (int a = 0; a < nbc - 1; a++) {
+        for (int b = a + 1; b < nbc; b++) {
+            long delta = swapDelta(rs, a, b);
+            if (delta > 0) { continue; }
+            swapCells(rs, a, b);
+            rs->value += delta;
+            if (delta < 0) { improved = 1; }
+        }
+    }
+    return improved;
+}
+
+int attemptSolveRectangle(RectangleSolver* rs) {
+    Graph* g = rs->r->g;
+    int nbc = rs->height * rs->width;
+    printf("Attempting solve for %s with goal precision: 0\n", g->name);
+
+    matchRectangleGoals(rs);
+    int i = 0;
+    while (rs->value > 0) {
+        showProgress(i, timeout);
+        if (i > timeout || nbc < 2) {
+            writeRectangleSolver(rs);
+            printDetails(1, 1, g, rs->k, rs->l, rs->d_k, rs->d_l, 0);
+            return 0;
+        }
+
+        if (!sweepRectangle(rs)) {
+            int a = rand() % nbc;
+            int b = rand() % (nbc - 1);
+            swapCells(rs, a, b < a ? b : b + 1);
+        }
+        matchRectangleGoals(rs);
+        i++;
+    }
+    writeRectangleSolver(rs);
+    printDetails(0, 1, g, rs->k, rs->l, rs->d_k, rs->d_l, 0);
+    return 1;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Rectangle.h"
+
+/**
+ * Works directly on the cells of a rectangle instead of its graph.
+ * The sums of the lines and columns are kept up to date, so a swap of two
+ * cells is scored in O(1).
+ *
+ * The weights are matched to the goal weights by sorting them, as in the
+ * graph objective. This matching is kept fixed during a sweep, so that a
+ * swap only changes the distance of the two lines and two columns it touches,
+ * and it is sorted again after each sweep.
+ *
+ * Use the createRectangleSolver function to properly create one
+ */
+typedef struct _rectangleSolver {
+    Rectangle* r;
+    int height;
+    int width;
+    // The cell (i, j) is cells[i * width + j], as in the table of the rectangle
+    int* cells;
+    int* lineSums;
+    int* columnSums;
+    // The goal weight matched with each line and column
+    int* lineGoals;
+    int* columnGoals;
+    // The lines and columns, sorted by weight
+    int* lineOrder;
+    int* columnOrder;
+    int k;
+    int l;
+    int d_k;
+    int d_l;
+    long value;
+} RectangleSolver;
+
+/**
+ * Creates a solver starting from the edge labels of the rectangle graph
+ * @param r The rectangle to solve
+ * @param k The constant of the lines
+ * @param l The constant of the columns
+ * @param d_k The step of the lines, 0 for magic lines
+ * @param d_l The step of the columns, 0 for magic columns
+ * @return The allocated solver
+ */
+RectangleSolver* createRectangleSolver(Rectangle* r, int k, int l, int d_k, int d_l);
+
+/**
+ * Frees the solver, the rectangle is untouched
+ * @param rs The solver to free
+ */
+void freeRectangleSolver(RectangleSolver* rs);
+
+/**
+ * Copies the cells of the solver in the edge labels of the rectangle graph
+ * @param rs The solver
+ */
+void writeRectangleSolver(RectangleSolver* rs);
+
+/**
+ * Tries to solve the rectangle: each sweep applies every swap of two cells
+ * that does not raise the distance to the goal weights, so that the search
+ * can move along the plateaus. A random swap is done when a sweep lowers
+ * nothing. At most timeout sweeps are done
+ * @param rs The solver, the attempt starts from its current cells
+ * @return 1 if the rectangle was solved, 0 if not
+ */
+int attemptSolveRectangle(RectangleSolver* rs);
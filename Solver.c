@@ -1,9 +1,12 @@
 #include "Solver.h"
 #include "Graph.h"
 #include "Rectangle.h"
+#include "RectangleSolver.h"
 #include "Utils.h"
+#include "Weights.h"
 
 #include <assert.h>
+#include <limits.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -30,31 +33,234 @@ int checksumLabel(Graph* g) {
     return 1;
 }
 
-Solver* createSolver(Graph* g) {
-    Solver* s = (Solver*)malloc(sizeof(Graph));
-    s->g = g;
-    s->tab = (IssuedEdges**)malloc(sizeof(IssuedEdges*) * g->nbv);
-    for (int i = 0; i < g->nbv; i++) {
-        s->tab[i] = getIssuedEdges(g, &(g->vertices[i]));
+/**
+ * Stamps the neighbours of each vertex with it, in one O(n+m) pass
+ * @return 1 if two edges issued from a vertex go to the same vertex
+ */
+int hasParallelEdges(Topology* t, int nbv) {
+    int* stamp = malloc((nbv + 1) * sizeof(int));
+    for (int v = 0; v < nbv; v++) {
+        stamp[v] = -1;
+    }
+    int res = 0;
+    for (int v = 0; v < nbv && !res; v++) {
+        for (int i = t->offsets[v]; i < t->offsets[v + 1] && !res; i++) {
+            int e = t->incidence[i];
+            int u = t->ends[2 * e] + t->ends[2 * e + 1] - v;
+            res = stamp[u] == v;
+            stamp[u] = v;
+        }
     }
+    free(stamp);
+    return res;
+}
 
+Topology* createTopology() {
+    Topology* t = (Topology*)malloc(sizeof(Topology));
+    t->maxNbv = 0;
+    t->maxNbe = 0;
+    t->ends = NULL;
+    t->offsets = NULL;
+    t->incidence = NULL;
+    t->users = 1;
+    return t;
+}
+
+void bindTopology(Topology* t, Graph* g) {
+    int nbv = g->nbv;
+    int nbe = g->nbe;
+
+    // The buffers only grow, so that they fit the largest graph seen
+    if (nbv > t->maxNbv || nbe > t->maxNbe) {
+        if (nbv > t->maxNbv) t->maxNbv = nbv;
+        if (nbe > t->maxNbe) t->maxNbe = nbe;
+        t->ends = realloc(t->ends, 2 * t->maxNbe * sizeof(int));
+        t->offsets = realloc(t->offsets, (t->maxNbv + 1) * sizeof(int));
+        t->incidence = realloc(t->incidence, 2 * t->maxNbe * sizeof(int));
+    }
+
+    // Counting sort of the edges by endpoint
+    getEdgesEndpoints(g, t->ends);
+    memset(t->offsets, 0, (nbv + 1) * sizeof(int));
+    for (int i = 0; i < 2 * nbe; i++) {
+        t->offsets[t->ends[i] + 1]++;
+    }
+    for (int i = 0; i < nbv; i++) {
+        t->offsets[i + 1] += t->offsets[i];
+    }
+    for (int i = 0; i < nbe; i++) {
+        t->incidence[t->offsets[t->ends[2 * i]]++] = i;
+        t->incidence[t->offsets[t->ends[2 * i + 1]]++] = i;
+    }
+    // The offsets were moved to the end of each vertex, we shift them back
+    for (int i = nbv; i > 0; i--) {
+        t->offsets[i] = t->offsets[i - 1];
+    }
+    t->offsets[0] = 0;
+
+    t->complete = 2 * nbe == nbv * (nbv - 1);
+    for (int i = 0, e = 0; t->complete && i < nbv; i++) {
+        for (int j = i + 1; t->complete && j < nbv; j++, e++) {
+            int u = t->ends[2 * e];
+            int v = t->ends[2 * e + 1];
+            t->complete = (u == i && v == j) || (u == j && v == i);
+        }
+    }
+    t->parallelEdges = hasParallelEdges(t, nbv);
+}
+
+/**
+ * Releases the topology of the solver, it is freed by its last user
+ */
+void releaseTopology(Solver* s) {
+    Topology* t = s->topology;
+    if (--t->users > 0) { return; }
+    free(t->ends);
+    free(t->offsets);
+    free(t->incidence);
+    free(t);
+}
+
+/**
+ * Allocates a solver without labels nor topology
+ */
+Solver* allocSolver() {
+    Solver* s = (Solver*)malloc(sizeof(Solver));
+    s->maxNbv = 0;
+    s->maxNbe = 0;
+    s->labels = NULL;
+    s->initialLabels = NULL;
+    s->bestLabels = NULL;
+    s->positions = NULL;
+    s->nbPositions = 0;
+    s->weights = NULL;
+    s->bounded = 0;
+    s->termOrder = NULL;
+    s->sortedWeights = NULL;
+    return s;
+}
+
+/**
+ * Sets the graph of the solver and grows its buffers for it
+ */
+void bindLabels(Solver* s, Graph* g) {
+    int nbv = g->nbv;
+    int nbe = g->nbe;
+
+    // The buffers only grow, so that they fit the largest graph seen
+    if (nbv > s->maxNbv || nbe > s->maxNbe) {
+        if (nbv > s->maxNbv) s->maxNbv = nbv;
+        if (nbe > s->maxNbe) s->maxNbe = nbe;
+        int n = s->maxNbv + s->maxNbe;
+        s->labels = realloc(s->labels, n * sizeof(int));
+        s->initialLabels = realloc(s->initialLabels, n * sizeof(int));
+        s->bestLabels = realloc(s->bestLabels, n * sizeof(int));
+        // The labels usually are 1 to n
+        if (n + 1 > s->nbPositions) {
+            s->nbPositions = n + 1;
+            s->positions = realloc(s->positions, s->nbPositions * sizeof(int));
+        }
+        s->weights = realloc(s->weights, s->maxNbv * sizeof(int));
+        s->termOrder = realloc(s->termOrder, s->maxNbv * sizeof(int));
+        s->sortedWeights = realloc(s->sortedWeights, s->maxNbv * sizeof(int));
+    }
+
+    s->g = g;
+    s->nbv = nbv;
+    s->nbe = nbe;
+}
+
+Solver* createSolver(Graph* g) {
+    Solver* s = allocSolver();
+    s->topology = createTopology();
+    bindSolver(s, g);
     return s;
 }
 
+Solver* shareSolver(Solver* s) {
+    Solver* res = allocSolver();
+    res->topology = s->topology;
+    res->topology->users++;
+    bindLabels(res, s->g);
+    memcpy(res->initialLabels, s->initialLabels, (s->nbv + s->nbe) * sizeof(int));
+    memcpy(res->labels, s->labels, (s->nbv + s->nbe) * sizeof(int));
+    indexLabels(res);
+    return res;
+}
+
+void bindSolver(Solver* s, Graph* g) {
+    // The topology of the other solvers sharing it must not change
+    if (s->topology->users > 1) {
+        releaseTopology(s);
+        s->topology = createTopology();
+    }
+    bindLabels(s, g);
+    bindTopology(s->topology, g);
+    getLabels(g, s->initialLabels);
+    memcpy(s->labels, s->initialLabels, (s->nbv + s->nbe) * sizeof(int));
+    indexLabels(s);
+}
+
 void freeSolver(Solver* s, int freeG) {
     if (freeG) freeGraph(s->g);
-    free(s->tab);
+    releaseTopology(s);
+    free(s->labels);
+    free(s->initialLabels);
+    free(s->bestLabels);
+    free(s->positions);
+    free(s->weights);
+    free(s->termOrder);
+    free(s->sortedWeights);
     free(s);
 }
 
-void printIssuedEdgesList(Solver* s) {
-    // Affiche tout les esges associées a chaque vertex dans un tableau
-    printf("[\n");
-    for (int i = 0; i < s->g->nbv; i++) {
+void resetSolver(Solver* s) {
+    memcpy(s->labels, s->initialLabels, (s->nbv + s->nbe) * sizeof(int));
+    indexLabels(s);
+}
 
-        printIssuedEdges(s->tab[i]);
+void indexLabels(Solver* s) {
+    int nbl = s->nbv + s->nbe;
+    int maxLabel = 0;
+    for (int i = 0; i < nbl; i++) {
+        if (s->labels[i] > maxLabel) { maxLabel = s->labels[i]; }
+    }
+    if (maxLabel + 1 > s->nbPositions) {
+        s->nbPositions = maxLabel + 1;
+        s->positions = realloc(s->positions, s->nbPositions * sizeof(int));
+    }
+    for (int i = 0; i < s->nbPositions; i++) {
+        s->positions[i] = -1;
+    }
+    for (int i = 0; i < nbl; i++) {
+        if (s->labels[i] >= 0) { s->positions[s->labels[i]] = i; }
+    }
+}
+
+void swapLabels(Solver* s, int a, int b) {
+    permuteTab(s->labels, a, b);
+    if (s->labels[a] >= 0) { s->positions[s->labels[a]] = a; }
+    if (s->labels[b] >= 0) { s->positions[s->labels[b]] = b; }
+}
+
+void shuffleSolver(Solver* s) {
+    int j;
+    // Fisher-Yates shuffle
+    for (int i = s->nbv + s->nbe - 1; i > 0; i--) {
+        j = rand() % (i + 1);
+        swapLabels(s, i, j);
+    }
+}
+
+void writeSolver(Solver* s) { setLabels(s->g, s->labels); }
+
+void getWeights(Solver* s, int* weights) {
+    if (s->topology->complete) {
+        weightsComplete(s->labels, s->nbv, weights);
+    } else {
+        weightsFromIncidence(s->labels, s->nbv, s->topology->offsets, s->topology->incidence,
+                             weights);
     }
-    printf(" ]\n");
 }
 
 int* labelOfVertices(Graph* g) {
@@ -68,11 +274,12 @@ int* labelOfVertices(Graph* g) {
 }
 
 int getMagicConst(Graph* g) {
-    Solver* s = createSolver(g);
-    int res = s->tab[0]->v->label;
-    for (int i = 0; i < s->tab[0]->size; i++) {
-        res += s->tab[0]->issuedEdges[i]->label;
+    IssuedEdges* v = getIssuedEdges(g, g->vertices);
+    int res = v->v->label;
+    for (int i = 0; i < v->size; i++) {
+        res += v->issuedEdges[i]->label;
     }
+    freeIssuedEdges(v);
     return res;
 }
 
@@ -87,35 +294,103 @@ void permuteIssuedEdges(Solver* s, int vertexIndex, int x, int y) {
     // We permute to same elements, nothing happens
     if (x == y) return;
 
-    // Retrieving issued edges of the selected vertex
-    IssuedEdges* issuedEdges = s->tab[vertexIndex];
-    if (x == 0) {
-        // Permuting the vertex label with one of its issued edge label
-        Vertex* v = issuedEdges->v;
-        Edge* e = issuedEdges->issuedEdges[y - 1];
-        int temp = v->label;
-        v->label = e->label;
-        e->label = temp;
+    // The element 0 is the vertex itself, the others are its issued edges
+    int* issuedEdges = s->topology->incidence + s->topology->offsets[vertexIndex] - 1;
+    int elemX = (x == 0) ? vertexIndex : s->nbv + issuedEdges[x];
+    int elemY = (y == 0) ? vertexIndex : s->nbv + issuedEdges[y];
+    swapLabels(s, elemX, elemY);
+}
 
-        return;
+/**
+ * The objectives on the sorted weights are sums of one term per rank
+ * @return The number of terms of the method
+ */
+int nbObjectiveTerms(int method, int nb) {
+    return (method == 0 || method == 5) ? nb : nb - 1;
+}
+
+/**
+ * @param weights The sorted weights
+ * @param i The rank of the term
+ * @param moyenne The mean gap between consecutive weights, for the methods 4 and 5
+ * @return The term of the rank i of the objective
+ */
+long objectiveTerm(int method, int* weights, int i, int k, int d, int moyenne) {
+    long gap;
+    switch (method) {
+    case 0:
+        return labs(weights[i] - k - (long)i * d);
+    case 3:
+        gap = weights[i + 1] - weights[i] - d;
+        return gap * gap;
+    case 4:
+        gap = weights[i + 1] - weights[i] - moyenne;
+        return gap * gap;
+    case 5:
+        gap = weights[i] - (k + (long)i * moyenne);
+        return gap * gap;
+    default:
+        return weights[i + 1] == weights[i];
     }
+}
 
-    if (y == 0) {
-        Vertex* v = issuedEdges->v;
-        Edge* e = issuedEdges->issuedEdges[x - 1];
-        int temp = v->label;
-        v->label = e->label;
-        e->label = temp;
-        return;
+/**
+ * @return 1 if the terms of the method are on the weights in increasing order,
+ * -1 in decreasing order, 0 in the order of the vertices
+ */
+int weightOrder(int method, int d) {
+    // Without step, a VMT does not depend on the order of the weights
+    if (method == 0 || method == 3) { return (d > 0) - (d < 0); }
+    return 1;
+}
+
+/**
+ * Fills the weights in the order of the ranks of the terms of the method
+ */
+void sortedWeights(int method, Solver* s, int d, int* weights) {
+    getWeights(s, weights);
+    int order = weightOrder(method, d);
+    if (order < 0) qsort(weights, s->nbv, sizeof(int), cmp_inv);
+    if (order > 0) qsort(weights, s->nbv, sizeof(int), cmp);
+}
+
+/**
+ * @param weights The weights in the order of the ranks of the terms
+ * @return The mean gap between consecutive weights, used by the methods 4 and 5
+ */
+int meanGap(int method, int* weights, int nb) {
+    if (method != 4 && method != 5) { return 0; }
+    // The sum of the gaps between consecutive weights, divided by their number
+    return (weights[nb - 1] - weights[0]) / (nb - 1);
+}
+
+/**
+ * Sums the terms of an objective on the sorted weights. The sum stops as soon as
+ * it reaches the bound, the result is then at least the bound but not the objective
+ * @param bound LONG_MAX to compute the whole objective
+ * @param order The ranks in the order they are summed, NULL for their order
+ */
+long sumTerms(int method, int* weights, int nb, int k, int d, long bound, const int* order) {
+    int moyenne = meanGap(method, weights, nb);
+    long res = 0;
+    int nbTerms = nbObjectiveTerms(method, nb);
+    for (int t = 0; t < nbTerms; t++) {
+        res += objectiveTerm(method, weights, order ? order[t] : t, k, d, moyenne);
+        if (res >= bound) { return res; }
     }
+    return res;
+}
 
-    // Permuting 2 edges labels
-    Edge* e1 = issuedEdges->issuedEdges[y - 1];
-    Edge* e2 = issuedEdges->issuedEdges[x - 1];
-    int temp = e1->label;
-    e1->label = e2->label;
-    e2->label = temp;
-    return;
+/**
+ * Computes an objective on the sorted weights, one term per rank
+ * @param method 0, 3, 4, 5 or 6, see objective
+ * @param k The magic constant for the method 0, the first weight for the method 5
+ * @param d The step for the methods 0 and 3
+ */
+long sortedObjective(int method, Solver* s, int k, int d) {
+    int weights[s->nbv];
+    sortedWeights(method, s, d, weights);
+    return sumTerms(method, weights, s->nbv, k, d, LONG_MAX, NULL);
 }
 
 /**
@@ -125,58 +400,29 @@ void permuteIssuedEdges(Solver* s, int vertexIndex, int x, int y) {
  * @param k_d The antimagic step
  * @return 0 if the graph is (k, k_d)-antimagic
  */
-int magicFormula(Solver* s, int k, int k_d) {
-    int res = 0;
-    int nb = s->g->nbv;
-
-    int weights[nb];
-
-    int temp;
-    for (int i = 0; i < nb; i++) {
-        temp = (s->tab[i]->v->label);
-        for (int j = 0; j < s->tab[i]->size; j++) {
-            temp += s->tab[i]->issuedEdges[j]->label;
-        }
-        weights[i] = temp;
-    }
-
-    if (k_d < 0) qsort(weights, nb, sizeof(int), cmp_inv);
-    if (k_d > 0) qsort(weights, nb, sizeof(int), cmp);
-    for (int i = 0; i < nb; i++) {
-        weights[i] = abs(weights[i] - k - i * k_d);
-        res += weights[i];
-    }
-
-    return res;
+long magicFormula(Solver* s, int k, int k_d) {
+    return sortedObjective(0, s, k, k_d);
 }
 
 /**
- * Get the heuristic of the current graph
+ * Get the heuristic of the current graph, the variance of the weights times
+ * the square of the number of vertices, so that it is an exact integer
  * @param s The solver to study
  * @return 0 if the graph is magic
  */
-float magicFormulaUnknownConst(Solver* s) {
-    float res = 0;
-    int nb = s->g->nbv;
+long magicFormulaUnknownConst(Solver* s) {
+    int nb = s->nbv;
 
     int weights[nb];
 
-    int temp;
-    for (int i = 0; i < nb; i++) {
-        temp = (s->tab[i]->v->label);
-        for (int j = 0; j < s->tab[i]->size; j++) {
-            temp += s->tab[i]->issuedEdges[j]->label;
-        }
-        weights[i] = temp;
-        res += weights[i];
-    }
-
-    float avg = res / nb;
-    res = 0;
+    getWeights(s, weights);
+    long sum = 0;
+    long squares = 0;
     for (int i = 0; i < nb; i++) {
-        res += (weights[i] - avg) * (weights[i] - avg);
+        sum += weights[i];
+        squares += (long)weights[i] * weights[i];
     }
-    return res;
+    return nb * squares - sum * sum;
 }
 
 /**
@@ -184,30 +430,10 @@ float magicFormulaUnknownConst(Solver* s) {
  * @param s The solver to study
  * @return 0 if the graph is antimagic of step d
  */
-float antimagicFormulaKnownStep(Solver* s, int d) {
+long antimagicFormulaKnownStep(Solver* s, int d) {
     // Renvoie un nombre, plus le nombre est proche de 0, plus le graphe est
     // proche d'etre magique
-    float res = 0;
-    int nb = s->g->nbv;
-
-    int weights[nb];
-
-    int temp;
-    for (int i = 0; i < nb; i++) {
-        temp = (s->tab[i]->v->label);
-        for (int j = 0; j < s->tab[i]->size; j++) {
-            temp += s->tab[i]->issuedEdges[j]->label;
-        }
-        weights[i] = temp;
-    }
-
-    if (d < 0) qsort(weights, nb, sizeof(int), cmp_inv);
-    if (d > 0) qsort(weights, nb, sizeof(int), cmp);
-
-    for (int i = 0; i < nb - 1; i++) {
-        res += (weights[i + 1] - weights[i] - d) * (weights[i + 1] - weights[i] - d);
-    }
-    return res;
+    return sortedObjective(3, s, 0, d);
 }
 
 /**
@@ -215,87 +441,14 @@ float antimagicFormulaKnownStep(Solver* s, int d) {
  * @param s The solver to study
  * @return 0 if the graph is antimagic
  */
-float antimagicFormulaUnknownConst(Solver* s) {
-    // Renvoie un nombre, plus le nombre est proche de 0, plus le graphe est
-    // proche d'etre magique
-    float res = 0;
-    int nb = s->g->nbv;
-    int moyenne;
-    int weights[nb];
-
-    int temp;
-    for (int i = 0; i < nb; i++) {
-        temp = (s->tab[i]->v->label);
-        for (int j = 0; j < s->tab[i]->size; j++) {
-            temp += s->tab[i]->issuedEdges[j]->label;
-        }
-        weights[i] = temp;
-    }
-
-    qsort(weights, nb, sizeof(int), cmp);
-
-    for (int i = 0; i < nb - 1; i++) {
-        res += weights[i + 1] - weights[i];
-    }
-    moyenne = res / (nb - 1);
-    res = 0;
-    for (int i = 0; i < nb - 1; i++) {
-        res += (weights[i + 1] - weights[i] - moyenne) * (weights[i + 1] - weights[i] - moyenne);
-    }
-
-    return res;
+long antimagicFormulaUnknownConst(Solver* s) {
+    return sortedObjective(4, s, 0, 0);
 }
-float antimagicFormulaKnownConst(Solver* s, int a) {
-    // Renvoie un nombre, plus le nombre est proche de 0, plus le graphe est
-    // proche d'etre magique
-    float res = 0;
-    int nb = s->g->nbv;
-    int moyenne;
-    int weights[nb];
-
-    int temp;
-    for (int i = 0; i < nb; i++) {
-        temp = (s->tab[i]->v->label);
-        for (int j = 0; j < s->tab[i]->size; j++) {
-            temp += s->tab[i]->issuedEdges[j]->label;
-        }
-        weights[i] = temp;
-    }
-
-    qsort(weights, nb, sizeof(int), cmp);
-
-    for (int i = 0; i < nb - 1; i++) {
-        res += weights[i + 1] - weights[i];
-    }
-    moyenne = res / (nb - 1);
-    res = 0;
-    for (int i = 0; i < nb; i++) {
-        res += (weights[i] - (a + i * moyenne)) * (weights[i] - (a + i * moyenne));
-    }
-    return res;
+long antimagicFormulaKnownConst(Solver* s, int a) {
+    return sortedObjective(5, s, a, 0);
 }
-float allDifferentFormula(Solver* s) {
-    // Renvoie un nombre, plus le nombre est proche de 0, plus le graphe est
-    // proche d'etre magique
-    float res = 0;
-    int nb = s->g->nbv;
-    int weights[nb];
-
-    int temp;
-    for (int i = 0; i < nb; i++) {
-        temp = (s->tab[i]->v->label);
-        for (int j = 0; j < s->tab[i]->size; j++) {
-            temp += s->tab[i]->issuedEdges[j]->label;
-        }
-        weights[i] = temp;
-    }
-
-    qsort(weights, nb, sizeof(int), cmp);
-
-    for (int i = 0; i < nb - 1; i++) {
-        res += (weights[i + 1] == weights[i]);
-    }
-    return res;
+long allDifferentFormula(Solver* s) {
+    return sortedObjective(6, s, 0, 0);
 }
 
 /**
@@ -306,18 +459,11 @@ float allDifferentFormula(Solver* s) {
  */
 void getAntimagicConst(Solver* s, int* k, int* d_k) {
 
-    int nb = s->g->nbv;
+    int nb = s->nbv;
 
     int weights[nb];
 
-    int temp;
-    for (int i = 0; i < nb; i++) {
-        temp = (s->tab[i]->v->label);
-        for (int j = 0; j < s->tab[i]->size; j++) {
-            temp += s->tab[i]->issuedEdges[j]->label;
-        }
-        weights[i] = temp;
-    }
+    getWeights(s, weights);
     qsort(weights, nb, sizeof(int), cmp);
     int d = weights[1] - weights[0];
     for (int i = 1; i < nb - 1; i++) {
@@ -337,18 +483,11 @@ void getAntimagicConst(Solver* s, int* k, int* d_k) {
  * @return 1 if the graph is antimagic of step d, 0 if not
  */
 int IsAntimagicStep(Solver* s, int d) {
-    int nb = s->g->nbv;
+    int nb = s->nbv;
 
     int weights[nb];
 
-    int temp;
-    for (int i = 0; i < nb; i++) {
-        temp = (s->tab[i]->v->label);
-        for (int j = 0; j < s->tab[i]->size; j++) {
-            temp += s->tab[i]->issuedEdges[j]->label;
-        }
-        weights[i] = temp;
-    }
+    getWeights(s, weights);
     qsort(weights, nb, sizeof(int), cmp);
 
     for (int i = 0; i < nb - 1; i++) {
@@ -369,18 +508,11 @@ int IsAntimagicStep(Solver* s, int d) {
  */
 int IsAntimagic(Solver* s, int a, int d) {
 
-    int nb = s->g->nbv;
+    int nb = s->nbv;
 
     int weights[nb];
 
-    int temp;
-    for (int i = 0; i < nb; i++) {
-        temp = (s->tab[i]->v->label);
-        for (int j = 0; j < s->tab[i]->size; j++) {
-            temp += s->tab[i]->issuedEdges[j]->label;
-        }
-        weights[i] = temp;
-    }
+    getWeights(s, weights);
 
     qsort(weights, nb, sizeof(int), cmp);
     if (weights[0] != a) {
@@ -404,10 +536,10 @@ int IsAntimagic(Solver* s, int a, int d) {
  * @param d_v The antimagic step of columns
  * @return 0 if the rectangle is (u, d_u),(v, d_v)-antimagic (see reference)
  */
-int magicFormulaRectangle(Solver* s, int u, int v, int d_u, int d_v) {
+long magicFormulaRectangle(Solver* s, int u, int v, int d_u, int d_v) {
 
-    int res = 0;
-    int nb = s->g->nbv;
+    long res = 0;
+    int nb = s->nbv;
 
     int weightsColumn[nb];
     int weightsLign[nb];
@@ -416,16 +548,16 @@ int magicFormulaRectangle(Solver* s, int u, int v, int d_u, int d_v) {
     int height = 0;
     int width = 0;
 
+    int weights[nb];
+    getWeights(s, weights);
     for (int i = 0; i < nb; i++) {
-        temp = 0;
-        for (int j = 0; j < s->tab[i]->size; j++) {
-            temp += s->tab[i]->issuedEdges[j]->label;
-        }
+        // Only the labels of the edges count in a rectangle
+        temp = weights[i] - s->labels[i];
 
-        if (s->tab[i]->v->name[1] == '0') {
+        if (s->g->vertices[i].name[1] == '0') {
             weightsColumn[height] = temp;
             height++;
-        } else if (s->tab[i]->v->name[1] == '1') {
+        } else if (s->g->vertices[i].name[1] == '1') {
             weightsLign[width] = temp;
             width++;
         }
@@ -447,6 +579,16 @@ int magicFormulaRectangle(Solver* s, int u, int v, int d_u, int d_v) {
     return res;
 }
 
+long objective(int method, Solver* s, int k, int l, int d_k, int d_l) {
+    if (method == 0) { return magicFormula(s, k, d_k); }
+    if (method == 1) { return magicFormulaRectangle(s, k, l, d_k, d_l); }
+    if (method == 2) { return magicFormulaUnknownConst(s); }
+    if (method == 3) { return antimagicFormulaKnownStep(s, d_k); }
+    if (method == 4) { return antimagicFormulaUnknownConst(s); }
+    if (method == 5) { return antimagicFormulaKnownConst(s, k); }
+    return allDifferentFormula(s);
+}
+
 /**
  * Checks if the graph is magic knowing its constant
  * @param s The solver to study
@@ -455,13 +597,10 @@ int magicFormulaRectangle(Solver* s, int u, int v, int d_u, int d_v) {
  */
 int isMagic(Solver* s, int k) {
 
-    int res;
-    for (int i = 0; i < s->g->nbv; i++) {
-        res = (s->tab[i]->v->label);
-        for (int j = 0; j < s->tab[i]->size; j++) {
-            res += s->tab[i]->issuedEdges[j]->label;
-        }
-        if (res != k) { return 0; }
+    int weights[s->nbv];
+    getWeights(s, weights);
+    for (int i = 0; i < s->nbv; i++) {
+        if (weights[i] != k) { return 0; }
     }
     return 1;
 }
@@ -473,16 +612,297 @@ int isMagic(Solver* s, int k) {
  */
 int isMagicUnknwonConst(Solver* s) {
     // Renvoit 1 si le graphe est magique
-    int res;
-    int k;
-    for (int i = 0; i < s->g->nbv; i++) {
-        res = (s->tab[i]->v->label);
-        for (int j = 0; j < s->tab[i]->size; j++) {
-            res += s->tab[i]->issuedEdges[j]->label;
+    int weights[s->nbv];
+    getWeights(s, weights);
+    for (int i = 1; i < s->nbv; i++) {
+        if (weights[i] != weights[0]) { return 0; }
+    }
+    return 1;
+}
+
+/**
+ * Adds the change of weight of the endpoints of an element
+ * @param element The vertex or edge whose label changes
+ * @param change The difference between its new and old label
+ * @param vertices The vertices whose weight changes
+ * @param changes The change of weight of each of these vertices
+ * @param nb The number of vertices, at most 4
+ */
+void addWeightChange(Solver* s, int element, int change, int* vertices, int* changes,
+                     int* nb) {
+    int ends[2] = {element, -1};
+    if (element >= s->nbv) {
+        ends[0] = s->topology->ends[2 * (element - s->nbv)];
+        ends[1] = s->topology->ends[2 * (element - s->nbv) + 1];
+    }
+    for (int e = 0; e < 2 && ends[e] != -1; e++) {
+        int t = 0;
+        while (t < *nb && vertices[t] != ends[e]) { t++; }
+        if (t == *nb) {
+            vertices[(*nb)++] = ends[e];
+            changes[t] = 0;
         }
-        if (i == 0) { k = res; }
-        if (res != k) { return 0; }
+        changes[t] += change;
     }
+}
+
+/**
+ * @return The objective given the sum of the weights, the sum of their squares
+ * and the sum of their distances to k
+ */
+long swapObjective(int method, Solver* s, long sum, long squares, long distance) {
+    if (method == 0) { return distance; }
+    // See magicFormulaUnknownConst
+    return s->nbv * squares - sum * sum;
+}
+
+/**
+ * A term of the objective and its rank, to sort the ranks by term
+ */
+typedef struct _rankedTerm {
+    long term;
+    int rank;
+} RankedTerm;
+
+int cmpRankedTerms(const void* a, const void* b) {
+    long x = ((const RankedTerm*)a)->term;
+    long y = ((const RankedTerm*)b)->term;
+    return (x < y) - (x > y);
+}
+
+/**
+ * Sorts the weights of the current labels, and the ranks of the terms of the
+ * objective, the largest terms first
+ */
+void prepareBoundedScore(int method, Solver* s, int k, int d_k) {
+    getWeights(s, s->weights);
+    memcpy(s->sortedWeights, s->weights, s->nbv * sizeof(int));
+    s->weightOrder = weightOrder(method, d_k);
+    if (s->weightOrder < 0) qsort(s->sortedWeights, s->nbv, sizeof(int), cmp_inv);
+    if (s->weightOrder > 0) qsort(s->sortedWeights, s->nbv, sizeof(int), cmp);
+
+    int moyenne = meanGap(method, s->sortedWeights, s->nbv);
+    int nbTerms = nbObjectiveTerms(method, s->nbv);
+    RankedTerm terms[nbTerms];
+    for (int t = 0; t < nbTerms; t++) {
+        terms[t].term = objectiveTerm(method, s->sortedWeights, t, k, d_k, moyenne);
+        terms[t].rank = t;
+    }
+    qsort(terms, nbTerms, sizeof(RankedTerm), cmpRankedTerms);
+    for (int t = 0; t < nbTerms; t++) {
+        s->termOrder[t] = terms[t].rank;
+    }
+}
+
+int prepareSwapScore(int method, Solver* s, int k, int d_k) {
+    s->bounded = 0;
+    if (method != 2 && !(method == 0 && d_k == 0)) {
+        if (method != 1 && s->nbv >= 2) {
+            prepareBoundedScore(method, s, k, d_k);
+            s->bounded = 1;
+        }
+        return 0;
+    }
+    getWeights(s, s->weights);
+    s->weightSum = 0;
+    s->weightSquares = 0;
+    s->weightDistance = 0;
+    for (int i = 0; i < s->nbv; i++) {
+        long w = s->weights[i];
+        s->weightSum += w;
+        s->weightSquares += w * w;
+        s->weightDistance += labs(w - k);
+    }
+    s->scoreK = k;
+    s->score = swapObjective(method, s, s->weightSum, s->weightSquares, s->weightDistance);
+    return 1;
+}
+
+long swapScore(int method, Solver* s, int a, int b) {
+    int vertices[4];
+    int changes[4];
+    int nb = 0;
+    int delta = s->labels[b] - s->labels[a];
+    addWeightChange(s, a, delta, vertices, changes, &nb);
+    addWeightChange(s, b, -delta, vertices, changes, &nb);
+
+    long sum = s->weightSum;
+    long squares = s->weightSquares;
+    long distance = s->weightDistance;
+    for (int t = 0; t < nb; t++) {
+        long w = s->weights[vertices[t]];
+        long c = changes[t];
+        sum += c;
+        squares += 2 * w * c + c * c;
+        distance += labs(w + c - s->scoreK) - labs(w - s->scoreK);
+    }
+    return swapObjective(method, s, sum, squares, distance);
+}
+
+/**
+ * Replaces a weight by another in weights kept in order
+ * @param order The order of the weights, see weightOrder, not 0
+ */
+void replaceSortedWeight(int* sorted, int nb, int order, int old, int new) {
+    // The weights are in increasing order of order * weight
+    long key = (long)order * old;
+    int i = 0;
+    int high = nb - 1;
+    while (i < high) {
+        int middle = (i + high) / 2;
+        if (order * (long)sorted[middle] < key) {
+            i = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    key = (long)order * new;
+    while (i + 1 < nb && order * (long)sorted[i + 1] < key) {
+        sorted[i] = sorted[i + 1];
+        i++;
+    }
+    while (i > 0 && order * (long)sorted[i - 1] > key) {
+        sorted[i] = sorted[i - 1];
+        i--;
+    }
+    sorted[i] = new;
+}
+
+long boundedSwapScore(int method, Solver* s, int k, int d_k, long bound, int a, int b) {
+    int vertices[4];
+    int changes[4];
+    int nb = 0;
+    int delta = s->labels[b] - s->labels[a];
+    addWeightChange(s, a, delta, vertices, changes, &nb);
+    addWeightChange(s, b, -delta, vertices, changes, &nb);
+
+    // Only the weights of the endpoints change, they are moved in the sorted weights
+    int weights[s->nbv];
+    memcpy(weights, s->sortedWeights, s->nbv * sizeof(int));
+    for (int t = 0; t < nb; t++) {
+        if (changes[t] == 0) { continue; }
+        int w = s->weights[vertices[t]];
+        if (s->weightOrder == 0) {
+            weights[vertices[t]] += changes[t];
+        } else {
+            replaceSortedWeight(weights, s->nbv, s->weightOrder, w, w + changes[t]);
+        }
+    }
+    return sumTerms(method, weights, s->nbv, k, d_k, bound, s->termOrder);
+}
+
+/**
+ * @param fast 1 if prepareSwapScore was called for the current labels
+ * @param bound The best objective found so far, a swap reaching it is not scored exactly
+ * @return The objective after swapping the labels of the elements a and b, or a
+ * value at least the bound, the labels are left unchanged
+ */
+long scoreSwap(int method, Solver* s, int k, int l, int d_k, int d_l, int fast, long bound,
+               int a, int b) {
+    if (fast) { return swapScore(method, s, a, b); }
+    if (s->bounded) { return boundedSwapScore(method, s, k, d_k, bound, a, b); }
+    permuteTab(s->labels, a, b);
+    long res = objective(method, s, k, l, d_k, d_l);
+    permuteTab(s->labels, a, b);
+    return res;
+}
+
+/**
+ * The number of edges from which the scans of pairs of edges, and of vertices and
+ * edges, are replaced by the guided scan
+ */
+#define GUIDED_MIN_EDGES 1000
+// The number of deviations from the target tried for each label
+#define GUIDED_MAX_DEVIATIONS 16
+
+/**
+ * Collects the distinct deviations of the vertices on one side of the target,
+ * the largest ones first. Only the kept ones are sorted, by insertion
+ * @param sign 1 for the overweight vertices, -1 for the underweight ones
+ * @param deviations Where the absolute values of the deviations are stored
+ * @return The number of deviations, at most GUIDED_MAX_DEVIATIONS
+ */
+int collectDeviations(Solver* s, int target, int sign, int* deviations) {
+    int res = 0;
+    for (int v = 0; v < s->nbv; v++) {
+        int dev = sign * (s->weights[v] - target);
+        if (dev <= 0 || (res == GUIDED_MAX_DEVIATIONS && dev <= deviations[res - 1])) {
+            continue;
+        }
+        int i = res;
+        while (i > 0 && deviations[i - 1] < dev) {
+            i--;
+        }
+        if (i > 0 && deviations[i - 1] == dev) { continue; }
+        if (res < GUIDED_MAX_DEVIATIONS) { res++; }
+        memmove(deviations + i + 1, deviations + i, (res - 1 - i) * sizeof(int));
+        deviations[i] = dev;
+    }
+    return res;
+}
+
+/**
+ * Guided scan for large graphs: instead of all the pairs of elements, only the
+ * swaps moving a label from a vertex whose weight is above the target to a
+ * vertex whose weight is below are tried. A label of an overweight vertex is
+ * swapped with the label smaller by the deviation of the vertex, or by the
+ * deviation of an underweight vertex, found at once from the positions kept by
+ * the solver, and the opposite for the underweight vertices. The work only depends
+ * on the number of vertices off target, not on the number of pairs.
+ * prepareSwapScore must have been called on the current labels
+ *
+ * @param method The objective given to prepareSwapScore
+ * @param edgesOnly 1 to swap two edges, 0 to swap a vertex with an edge
+ * @return 1 if a better graph was found and applied, 0 if not
+ */
+int bestGuidedSwap(int method, Solver* s, int edgesOnly, int* tabooPermutations,
+                   int sizePT) {
+    // The target of the weights, the magic constant or the average weight
+    int target = method == 0 ? s->scoreK : (int)lround((double)s->weightSum / s->nbv);
+
+    int over[GUIDED_MAX_DEVIATIONS];
+    int under[GUIDED_MAX_DEVIATIONS];
+    int nbOver = collectDeviations(s, target, 1, over);
+    int nbUnder = collectDeviations(s, target, -1, under);
+
+    int* offsets = s->topology->offsets;
+    long bestValue = s->score;
+    int bestA = -1;
+    int bestB = -1;
+    for (int v = 0; v < s->nbv; v++) {
+        int dev = s->weights[v] - target;
+        if (dev == 0) { continue; }
+        // The labels of an overweight vertex go down, those of an underweight one go up
+        int sign = dev > 0 ? -1 : 1;
+        int* others = dev > 0 ? under : over;
+        int nbOthers = dev > 0 ? nbUnder : nbOver;
+        for (int t = offsets[v] - 1; t < offsets[v + 1]; t++) {
+            int a = t < offsets[v] ? v : s->nbv + s->topology->incidence[t];
+            if ((a < s->nbv && edgesOnly) || inTab(s->labels[a], tabooPermutations, sizePT)) {
+                continue;
+            }
+            for (int o = -1; o < nbOthers; o++) {
+                int shift = o == -1 ? abs(dev) : others[o];
+                int label = s->labels[a] + sign * shift;
+                if (label < 0 || label >= s->nbPositions || s->positions[label] == -1) {
+                    continue;
+                }
+                int b = s->positions[label];
+                // Two edges, or a vertex and an edge
+                int kind = edgesOnly ? b >= s->nbv : (a < s->nbv) != (b < s->nbv);
+                if (!kind) { continue; }
+                if (inTab(label, tabooPermutations, sizePT)) { continue; }
+                long value = swapScore(method, s, a, b);
+                if (value < bestValue) {
+                    bestValue = value;
+                    bestA = a;
+                    bestB = b;
+                }
+            }
+        }
+    }
+    if (bestA == -1) { return 0; }
+    swapLabels(s, bestA, bestB);
     return 1;
 }
 
@@ -505,55 +925,31 @@ int isMagicUnknwonConst(Solver* s) {
 int bestGraphByVertex(int method, Solver* s, int k, int l, int d_k, int d_l,
                       int* tabooPermutations, int sizePT) {
 
-    float magicVal;
-    if (method == 0) { magicVal = magicFormula(s, k, d_k); }
-    if (method == 1) { magicVal = magicFormulaRectangle(s, k, l, d_k, d_l); }
-    if (method == 2) { magicVal = magicFormulaUnknownConst(s); }
-    if (method == 3) { magicVal = antimagicFormulaKnownStep(s, d_k); }
-    if (method == 4) { magicVal = antimagicFormulaUnknownConst(s); }
-    if (method == 5) { magicVal = antimagicFormulaKnownConst(s, k); }
-    if (method == 6) { magicVal = allDifferentFormula(s); }
+    int fast = prepareSwapScore(method, s, k, d_k);
+    long magicVal;
+    magicVal = fast ? s->score : objective(method, s, k, l, d_k, d_l);
 
-    float currMagicVal;
+    long currMagicVal;
 
     int indexI = 0;
     int indexJ = 0;
 
-    int temp;
 
-    for (int j = 1; j < s->g->nbv; j++) {
+    for (int j = 1; j < s->nbv; j++) {
         for (int i = 0; i < j; i++) {
             // We check all issued edges not yet studied from the current label
-            if (inTab(s->g->vertices[i].label, tabooPermutations, sizePT) ||
-                inTab(s->g->vertices[j].label, tabooPermutations, sizePT)) {
+            if (inTab(s->labels[i], tabooPermutations, sizePT) ||
+                inTab(s->labels[j], tabooPermutations, sizePT)) {
                 continue;
             }
-            temp = s->g->vertices[i].label;
-            s->g->vertices[i].label = s->g->vertices[j].label;
-            s->g->vertices[j].label = temp;
-
             // Permuting current couple
-
-            if (method == 0) { currMagicVal = magicFormula(s, k, d_k); }
-            if (method == 1) {
-                currMagicVal = magicFormulaRectangle(s, k, l, d_k, d_l);
-            }
-            if (method == 2) { currMagicVal = magicFormulaUnknownConst(s); }
-            if (method == 3) { currMagicVal = antimagicFormulaKnownStep(s, d_k); }
-            if (method == 4) { currMagicVal = antimagicFormulaUnknownConst(s); }
-            if (method == 5) { currMagicVal = antimagicFormulaKnownConst(s, k); }
-            if (method == 6) { currMagicVal = allDifferentFormula(s); }
+            currMagicVal = scoreSwap(method, s, k, l, d_k, d_l, fast, magicVal, i, j);
             if (currMagicVal < magicVal) {
                 // This is a better graph, we save the permutation
                 indexI = i;
                 indexJ = j;
                 magicVal = currMagicVal;
             }
-
-            // We go back to the initial graph
-            temp = s->g->vertices[i].label;
-            s->g->vertices[i].label = s->g->vertices[j].label;
-            s->g->vertices[j].label = temp;
         }
     }
 
@@ -563,9 +959,7 @@ int bestGraphByVertex(int method, Solver* s, int k, int l, int d_k, int d_l,
     }
 
     // We permute to get the best graph
-    temp = s->g->vertices[indexI].label;
-    s->g->vertices[indexI].label = s->g->vertices[indexJ].label;
-    s->g->vertices[indexJ].label = temp;
+    swapLabels(s, indexI, indexJ);
 
     return 1;
 }
@@ -590,46 +984,53 @@ int bestGraphByVertex(int method, Solver* s, int k, int l, int d_k, int d_l,
 int bestGraphByVertexAndIssuedEdges(int method, Solver* s,
                                     int k, int l, int d_k, int d_l, int vertexIndex, int* tabooPermutations, int sizePT) {
 
-    float magicVal;
-    if (method == 0) { magicVal = magicFormula(s, k, d_k); }
-    if (method == 1) { magicVal = magicFormulaRectangle(s, k, l, d_k, d_l); }
-    if (method == 2) { magicVal = magicFormulaUnknownConst(s); }
-    if (method == 3) { magicVal = antimagicFormulaKnownStep(s, d_k); }
-    if (method == 4) { magicVal = antimagicFormulaUnknownConst(s); }
-    if (method == 5) { magicVal = antimagicFormulaKnownConst(s, k); }
-    if (method == 6) { magicVal = allDifferentFormula(s); }
-    float currMagicVal;
+    int fast = prepareSwapScore(method, s, k, d_k);
+    long magicVal;
+    magicVal = fast ? s->score : objective(method, s, k, l, d_k, d_l);
+    long currMagicVal;
     int indexI = 0;
     int indexJ = 0;
-    int check;
-    for (int j = 1; j < s->tab[vertexIndex]->size + 1; j++) {
+    Topology* topology = s->topology;
+    int* issuedEdges = topology->incidence + topology->offsets[vertexIndex];
+    int size = topology->offsets[vertexIndex + 1] - topology->offsets[vertexIndex];
+
+    // The element 0 is the vertex itself, the others are its issued edges
+    int elements[size + 1];
+    int labels[size + 1];
+    int taboo[size + 1];
+    long far[size + 1];
+    long deltas[size + 1];
+    elements[0] = vertexIndex;
+    for (int t = 1; t < size + 1; t++) {
+        int e = issuedEdges[t - 1];
+        elements[t] = s->nbv + e;
+        int* ends = topology->ends + 2 * e;
+        int farEnd = ends[0] == vertexIndex ? ends[1] : ends[0];
+        far[t] = fast ? s->weights[farEnd] : 0;
+    }
+    for (int t = 0; t < size + 1; t++) {
+        labels[t] = s->labels[elements[t]];
+        taboo[t] = inTab(labels[t], tabooPermutations, sizePT);
+    }
+    // Two edges going to the same vertex would share their far endpoint
+    int batch = fast && !topology->parallelEdges;
+
+    for (int j = 1; j < size + 1; j++) {
+        if (taboo[j]) { continue; }
+        if (batch) {
+            incidenceSwapDeltas(method, s->scoreK, labels, far, j, deltas);
+        }
         for (int i = 0; i < j; i++) { // On parcours tout les couples possibles
                                       // de voisins par le vertex correspondant
-
-            check = 0;
-
-            if (i == 0) {
-                check += inTab(s->tab[vertexIndex]->v->label,
-                               tabooPermutations, sizePT);
+            if (taboo[i]) { continue; }
+            if (batch && i > 0) {
+                currMagicVal = swapObjective(method, s, s->weightSum,
+                                             s->weightSquares + deltas[i],
+                                             s->weightDistance + deltas[i]);
             } else {
-                check += inTab(s->tab[vertexIndex]->issuedEdges[i - 1]->label,
-                               tabooPermutations, sizePT);
-            }
-            check += inTab(s->tab[vertexIndex]->issuedEdges[j - 1]->label,
-                           tabooPermutations, sizePT);
-
-            if (check > 0) { continue; }
-            permuteIssuedEdges(s, vertexIndex, i, j); // On permute le couple actuel
-
-            if (method == 0) { currMagicVal = magicFormula(s, k, d_k); }
-            if (method == 1) {
-                currMagicVal = magicFormulaRectangle(s, k, l, d_k, d_l);
+                currMagicVal = scoreSwap(method, s, k, l, d_k, d_l, fast, magicVal,
+                                         elements[i], elements[j]);
             }
-            if (method == 2) { currMagicVal = magicFormulaUnknownConst(s); }
-            if (method == 3) { currMagicVal = antimagicFormulaKnownStep(s, d_k); }
-            if (method == 4) { currMagicVal = antimagicFormulaUnknownConst(s); }
-            if (method == 5) { currMagicVal = antimagicFormulaKnownConst(s, k); }
-            if (method == 6) { currMagicVal = allDifferentFormula(s); }
 
             if (currMagicVal < magicVal) {
                 // New better permutation found
@@ -637,9 +1038,6 @@ int bestGraphByVertexAndIssuedEdges(int method, Solver* s,
                 indexJ = j;
                 magicVal = currMagicVal;
             }
-
-            // Going back to the initial graph
-            permuteIssuedEdges(s, vertexIndex, i, j);
         }
     }
     if ((indexI == 0) && (indexJ == 0)) {
@@ -668,48 +1066,30 @@ int bestGraphByVertexAndIssuedEdges(int method, Solver* s,
 int bestGraphByEdges(int method, Solver* s, int k, int l, int d_k, int d_l,
                      int* tabooPermutations, int sizePT) {
 
-    float magicValue;
-    if (method == 0) { magicValue = magicFormula(s, k, d_k); }
-    if (method == 1) { magicValue = magicFormulaRectangle(s, k, l, d_k, d_l); }
-    if (method == 2) { magicValue = magicFormulaUnknownConst(s); }
-    if (method == 3) { magicValue = antimagicFormulaKnownStep(s, d_k); }
-    if (method == 4) { magicValue = antimagicFormulaUnknownConst(s); }
-    if (method == 5) { magicValue = antimagicFormulaKnownConst(s, k); }
-    if (method == 6) { magicValue = allDifferentFormula(s); }
-    float currMagicValue;
+    int fast = prepareSwapScore(method, s, k, d_k);
+    if (fast && s->nbe >= GUIDED_MIN_EDGES) {
+        return bestGuidedSwap(method, s, 1, tabooPermutations, sizePT);
+    }
+    long magicValue;
+    magicValue = fast ? s->score : objective(method, s, k, l, d_k, d_l);
+    long currMagicValue;
     int indexI = 0;
     int indexJ = 0;
 
-    int temp;
 
-    for (int j = 1; j < s->g->nbe; j++) {
+    for (int j = 1; j < s->nbe; j++) {
         for (int i = 0; i < j; i++) {
-            if (inTab(s->g->edges[i].label, tabooPermutations, sizePT) ||
-                inTab(s->g->edges[j].label, tabooPermutations, sizePT)) {
+            if (inTab(s->labels[s->nbv + i], tabooPermutations, sizePT) ||
+                inTab(s->labels[s->nbv + j], tabooPermutations, sizePT)) {
                 continue;
             }
-            temp = s->g->edges[i].label;
-            s->g->edges[i].label = s->g->edges[j].label;
-            s->g->edges[j].label = temp;
-
-            if (method == 0) { currMagicValue = magicFormula(s, k, d_k); }
-            if (method == 1) {
-                currMagicValue = magicFormulaRectangle(s, k, l, d_k, d_l);
-            }
-            if (method == 2) { currMagicValue = magicFormulaUnknownConst(s); }
-            if (method == 3) { currMagicValue = antimagicFormulaKnownStep(s, d_k); }
-            if (method == 4) { currMagicValue = antimagicFormulaUnknownConst(s); }
-            if (method == 5) { currMagicValue = antimagicFormulaKnownConst(s, k); }
-            if (method == 6) { currMagicValue = allDifferentFormula(s); }
+            currMagicValue = scoreSwap(method, s, k, l, d_k, d_l, fast, magicValue,
+                                       s->nbv + i, s->nbv + j);
             if (currMagicValue < magicValue) {
                 indexI = i;
                 indexJ = j;
                 magicValue = currMagicValue;
             }
-
-            temp = s->g->edges[i].label;
-            s->g->edges[i].label = s->g->edges[j].label;
-            s->g->edges[j].label = temp;
         }
     }
     if ((indexI == 0) && (indexJ == 0)) {
@@ -717,9 +1097,7 @@ int bestGraphByEdges(int method, Solver* s, int k, int l, int d_k, int d_l,
         return 0;
     }
 
-    temp = s->g->edges[indexI].label;
-    s->g->edges[indexI].label = s->g->edges[indexJ].label;
-    s->g->edges[indexJ].label = temp;
+    swapLabels(s, s->nbv + indexI, s->nbv + indexJ);
 
     return 1;
 }
@@ -743,48 +1121,30 @@ int bestGraphByEdges(int method, Solver* s, int k, int l, int d_k, int d_l,
 int bestGraphByVerticesAndEdges(int method, Solver* s, int k, int l, int d_k,
                                 int d_l, int* tabooPermutations, int sizePT) {
 
-    float magicValue;
-    if (method == 0) { magicValue = magicFormula(s, k, d_k); }
-    if (method == 1) { magicValue = magicFormulaRectangle(s, k, l, d_k, d_l); }
-    if (method == 2) { magicValue = magicFormulaUnknownConst(s); }
-    if (method == 3) { magicValue = antimagicFormulaKnownStep(s, d_k); }
-    if (method == 4) { magicValue = antimagicFormulaUnknownConst(s); }
-    if (method == 5) { magicValue = antimagicFormulaKnownConst(s, k); }
-    if (method == 6) { magicValue = allDifferentFormula(s); }
-    float currMagicValue;
+    int fast = prepareSwapScore(method, s, k, d_k);
+    if (fast && s->nbe >= GUIDED_MIN_EDGES) {
+        return bestGuidedSwap(method, s, 0, tabooPermutations, sizePT);
+    }
+    long magicValue;
+    magicValue = fast ? s->score : objective(method, s, k, l, d_k, d_l);
+    long currMagicValue;
     int indexI = 0;
     int indexJ = 0;
 
-    int temp;
 
-    for (int j = 0; j < s->g->nbe; j++) {
-        for (int i = 0; i < s->g->nbv; i++) {
-            if (inTab(s->g->vertices[i].label, tabooPermutations, sizePT) ||
-                inTab(s->g->edges[j].label, tabooPermutations, sizePT)) {
+    for (int j = 0; j < s->nbe; j++) {
+        for (int i = 0; i < s->nbv; i++) {
+            if (inTab(s->labels[i], tabooPermutations, sizePT) ||
+                inTab(s->labels[s->nbv + j], tabooPermutations, sizePT)) {
                 continue;
             }
-            temp = s->g->vertices[i].label;
-            s->g->vertices[i].label = s->g->edges[j].label;
-            s->g->edges[j].label = temp;
-
-            if (method == 0) { currMagicValue = magicFormula(s, k, d_k); }
-            if (method == 1) {
-                currMagicValue = magicFormulaRectangle(s, k, l, d_k, d_l);
-            }
-            if (method == 2) { currMagicValue = magicFormulaUnknownConst(s); }
-            if (method == 3) { currMagicValue = antimagicFormulaKnownStep(s, d_k); }
-            if (method == 4) { currMagicValue = antimagicFormulaUnknownConst(s); }
-            if (method == 5) { currMagicValue = antimagicFormulaKnownConst(s, k); }
-            if (method == 6) { currMagicValue = allDifferentFormula(s); }
+            currMagicValue = scoreSwap(method, s, k, l, d_k, d_l, fast, magicValue, i,
+                                            s->nbv + j);
             if (currMagicValue < magicValue) {
                 indexI = i;
                 indexJ = j;
                 magicValue = currMagicValue;
             }
-
-            temp = s->g->vertices[i].label;
-            s->g->vertices[i].label = s->g->edges[j].label;
-            s->g->edges[j].label = temp;
         }
     }
     if ((indexI == 0) &&
@@ -793,9 +1153,7 @@ int bestGraphByVerticesAndEdges(int method, Solver* s, int k, int l, int d_k,
         return 0;
     }
 
-    temp = s->g->vertices[indexI].label;
-    s->g->vertices[indexI].label = s->g->edges[indexJ].label;
-    s->g->edges[indexJ].label = temp;
+    swapLabels(s, indexI, s->nbv + indexJ);
 
     return 1;
 }
@@ -818,24 +1176,18 @@ int bestGraphByVerticesAndEdges(int method, Solver* s, int k, int l, int d_k,
  */
 // TODO test
 void attemptSolveVertexAndIssuedEdges(int method, Solver* s, int k, int l, int d_k,
-                                      int d_l, float precision, int* tabooPermutations,
+                                      int d_l, long precision, int* tabooPermutations,
                                       int sizePT) {
 
     // We found out that randomness was less reliable that trying for all vertices
     // In the future, we would like to understand why and optimize this variable
     int randomTimeout = 3;
     int randomIndex;
-    int nbv = s->g->nbv;
+    int nbv = s->nbv;
     int iterCount = 0;
     int control;
-    float magicValue;
-    if (method == 0) { magicValue = magicFormula(s, k, d_k); }
-    if (method == 1) { magicValue = magicFormulaRectangle(s, k, l, d_k, d_l); }
-    if (method == 2) { magicValue = magicFormulaUnknownConst(s); }
-    if (method == 3) { magicValue = antimagicFormulaKnownStep(s, d_k); }
-    if (method == 4) { magicValue = antimagicFormulaUnknownConst(s); }
-    if (method == 5) { magicValue = antimagicFormulaKnownConst(s, k); }
-    if (method == 6) { magicValue = allDifferentFormula(s); }
+    long magicValue;
+    magicValue = objective(method, s, k, l, d_k, d_l);
     while (magicValue > precision) {
         if (iterCount > randomTimeout) {
             control = 0;
@@ -864,21 +1216,7 @@ void attemptSolveVertexAndIssuedEdges(int method, Solver* s, int k, int l, int d
             // Randomness did not give a better graph
             iterCount++;
         }
-        if (method == 0) {
-            magicValue = magicFormula(s, k, d_k);
-        } else if (method == 1) {
-            magicValue = magicFormulaRectangle(s, k, l, d_k, d_l);
-        } else if (method == 2) {
-            magicValue = magicFormulaUnknownConst(s);
-        } else if (method == 3) {
-            magicValue = antimagicFormulaKnownStep(s, d_k);
-        } else if (method == 4) {
-            magicValue = antimagicFormulaUnknownConst(s);
-        } else if (method == 5) {
-            magicValue = antimagicFormulaKnownConst(s, k);
-        } else if (method == 6) {
-            magicValue = allDifferentFormula(s);
-        }
+        magicValue = objective(method, s, k, l, d_k, d_l);
     }
     return;
 }
@@ -892,57 +1230,56 @@ void attemptSolveVertexAndIssuedEdges(int method, Solver* s, int k, int l, int d
 void newCloseGraph(Solver* s, int* tabooPermutations, int sizePT) {
     // Permute deux labels dans le graphe
 
-    int nbv = s->g->nbv;
-    int nbe = s->g->nbe;
+    int nbv = s->nbv;
+    int nbe = s->nbe;
     int label1;
     int label2;
     int numv1;
     do {
         numv1 = rand() % (nbe + nbv);
         if (numv1 < nbe) {
-            label1 = s->g->edges[numv1].label;
+            label1 = s->labels[s->nbv + numv1];
         } else {
-            label1 = s->g->vertices[numv1 - nbe].label;
+            label1 = s->labels[numv1 - nbe];
         }
     } while (inTab(label1, tabooPermutations, sizePT));
     int numv2;
-    int temp;
     do {
         numv2 = rand() % (nbe + nbv);
         if (numv2 < nbe) {
-            label2 = s->g->edges[numv2].label;
+            label2 = s->labels[s->nbv + numv2];
         } else {
-            label2 = s->g->vertices[numv2 - nbe].label;
+            label2 = s->labels[numv2 - nbe];
         }
     } while (numv1 == numv2 || inTab(label2, tabooPermutations, sizePT));
 
     if (numv1 < nbe) {
         if (numv2 < nbe) {
-            temp = s->g->edges[numv1].label;
-            s->g->edges[numv1].label = s->g->edges[numv2].label;
-            s->g->edges[numv2].label = temp;
+            swapLabels(s, s->nbv + numv1, s->nbv + numv2);
             return;
         }
         numv2 -= nbe;
-        temp = s->g->edges[numv1].label;
-        s->g->edges[numv1].label = s->g->vertices[numv2].label;
-        s->g->vertices[numv2].label = temp;
+        swapLabels(s, s->nbv + numv1, numv2);
         return;
     }
     numv1 -= nbe;
     if (numv2 < nbe) {
-        temp = s->g->vertices[numv1].label;
-        s->g->vertices[numv1].label = s->g->edges[numv2].label;
-        s->g->edges[numv2].label = temp;
+        swapLabels(s, numv1, s->nbv + numv2);
         return;
     }
     numv2 -= nbe;
-    temp = s->g->vertices[numv1].label;
-    s->g->vertices[numv1].label = s->g->vertices[numv2].label;
-    s->g->vertices[numv2].label = temp;
+    swapLabels(s, numv1, numv2);
     return;
 }
 
+void perturbSolver(Solver* s, int strength, int* tabooPermutations, int sizePT) {
+    // Not enough labels that can move
+    if (s->nbv + s->nbe - sizePT < 2) { return; }
+    for (int i = 0; i < strength; i++) {
+        newCloseGraph(s, tabooPermutations, sizePT);
+    }
+}
+
 /**
  * Permute 2 consecutive labels regardless the heuristic
  * @param s The solver to study
@@ -951,8 +1288,8 @@ void newCloseGraph(Solver* s, int* tabooPermutations, int sizePT) {
  */
 int newVeryCloseGraph(Solver* s, int enableVertexPermutations) {
     // Permute deux labels consecutifs du graphe
-    int nbv = s->g->nbv;
-    int nbe = s->g->nbe;
+    int nbv = s->nbv;
+    int nbe = s->nbe;
     int indice;
     int label;
 
@@ -961,47 +1298,42 @@ int newVeryCloseGraph(Solver* s, int enableVertexPermutations) {
 
         if (eouv < nbv) {
             indice = rand() % nbv;
-            label = s->g->vertices[indice].label;
+            label = s->labels[indice];
             for (int i = 0; i < nbv; i++) {
-                if (abs(s->g->vertices[i].label - label) == 1) {
-                    s->g->vertices[indice].label = s->g->vertices[i].label;
-                    s->g->vertices[i].label = label;
+                if (abs(s->labels[i] - label) == 1) {
+                    swapLabels(s, indice, i);
                     return 1;
                 }
             }
             for (int i = 0; i < nbe; i++) {
-                if (abs(s->g->edges[i].label - label) == 1) {
-                    s->g->vertices[indice].label = s->g->edges[i].label;
-                    s->g->edges[i].label = label;
+                if (abs(s->labels[s->nbv + i] - label) == 1) {
+                    swapLabels(s, indice, s->nbv + i);
                     return 1;
                 }
             }
             return 0;
         }
         indice = rand() % nbe;
-        label = s->g->edges[indice].label;
+        label = s->labels[s->nbv + indice];
         for (int i = 0; i < nbv; i++) {
-            if (abs(s->g->vertices[i].label - label) == 1) {
-                s->g->edges[indice].label = s->g->vertices[i].label;
-                s->g->vertices[i].label = label;
+            if (abs(s->labels[i] - label) == 1) {
+                swapLabels(s, s->nbv + indice, i);
                 return 1;
             }
         }
         for (int i = 0; i < nbe; i++) {
-            if (abs(s->g->edges[i].label - label) == 1) {
-                s->g->edges[indice].label = s->g->edges[i].label;
-                s->g->edges[i].label = label;
+            if (abs(s->labels[s->nbv + i] - label) == 1) {
+                swapLabels(s, s->nbv + indice, s->nbv + i);
                 return 1;
             }
         }
 
     } else {
         for (int i = 1; i < nbe; i++) {
-            label = s->g->edges[i].label;
+            label = s->labels[s->nbv + i];
             for (int j = 0; j < i; j++) {
-                if (abs(s->g->edges[j].label - label) == 1) {
-                    s->g->edges[i].label = s->g->edges[j].label;
-                    s->g->edges[j].label = label;
+                if (abs(s->labels[s->nbv + j] - label) == 1) {
+                    swapLabels(s, s->nbv + i, s->nbv + j);
                     return 1;
                 }
             }
@@ -1010,25 +1342,14 @@ int newVeryCloseGraph(Solver* s, int enableVertexPermutations) {
     return 0;
 }
 
-/**
- * Logs the result of the solve attempt
- * @param failed 1 to log a failed operation
- * @param method 0 to log a graph operation, 1 to log a rectangle operation
- * @param g The graph on wich we log operation
- * @param k The goal constant, in method 1 for the columns
- * @param l The line constant, in method 0 this is ignored
- * @param d_k The antimagic step, in method 1 for the columns
- * @param d_l The antimagic step for lines, in method 0 this is ignored
- * @param precision Target precision
- */
 void printDetails(int failed, int method, Graph* g, int k, int l, int d_k,
-                  int d_l, int precision) {
+                  int d_l, long precision) {
     failed ? printf(ANSI_COLOR_RED "Failed to solve %s ", g->name)
            : printf(ANSI_COLOR_GREEN "\nSuccessfully solved %s ", g->name);
     if (method == 0) {
-        (d_k) ? printf("for a (%d, %d)-VAT with goal precision of %d", k, d_k,
+        (d_k) ? printf("for a (%d, %d)-VAT with goal precision of %ld", k, d_k,
                        precision)
-              : printf("for a %d-VMT with goal precision of %d", k, precision);
+              : printf("for a %d-VMT with goal precision of %ld", k, precision);
     }
     if (method == 1) {
         (d_k) ? printf("for a (%d, %d)-antimagic columns ", k, d_k)
@@ -1037,11 +1358,67 @@ void printDetails(int failed, int method, Graph* g, int k, int l, int d_k,
               : printf("and %d-magic ligns", l);
     }
     if (method == 2) {
-        printf("for a %d-VMT with goal precision of %d", getMagicConst(g), precision);
+        printf("for a %d-VMT with goal precision of %ld", getMagicConst(g), precision);
     }
     printf(ANSI_RESET_ALL "\n");
 }
 
+void cascadeStep(int method, Solver* s, int k, int l, int d_k, int d_l,
+                 long precision, int* tabooPermutations, int sizePT) {
+    if (!bestGraphByVertex(method, s, k, l, d_k, d_l,
+                           tabooPermutations, sizePT)) {
+        if (!bestGraphByEdges(method, s, k, l, d_k, d_l,
+                              tabooPermutations, sizePT)) {
+            if (!bestGraphByVerticesAndEdges(method, s, k, l, d_k, d_l,
+                                             tabooPermutations, sizePT)) {
+
+                newCloseGraph(s, tabooPermutations, sizePT);
+            }
+        }
+    }
+
+    attemptSolveVertexAndIssuedEdges(method, s, k, l, d_k, d_l, precision,
+                                     tabooPermutations, sizePT);
+}
+
+/**
+ * Same as attemptSolveWithThreshold, but reuses a solver that was already created.
+ * The labels the attempt starts from are the current labels of the solver
+ *
+ * @return 	1 if the solution was found, 0 if not
+ * */
+int attemptSolveWithSolverAndThreshold(int method, Solver* s, int k, int l,
+                                       int d_k, int d_l, long precision,
+                                       int* tabooPermutations, int sizePT) {
+    Graph* g = s->g;
+    printf("Attempting solve for %s with goal precision: %ld\n", g->name, precision);
+
+    int i = 0;
+    long magicValue;
+    magicValue = objective(method, s, k, l, d_k, d_l);
+
+    while (magicValue > precision) {
+
+        showProgress(i, timeout);
+
+        if (i > timeout) {
+            writeSolver(s);
+            printDetails(1, method, g, k, l, d_k, d_l, precision);
+            return 0;
+        }
+
+        cascadeStep(method, s, k, l, d_k, d_l, precision, tabooPermutations, sizePT);
+
+        i++;
+
+        magicValue = objective(method, s, k, l, d_k, d_l);
+    }
+    writeSolver(s);
+    printDetails(0, method, g, k, l, d_k, d_l, precision);
+
+    return 1;
+}
+
 /**
  * Attemps to solve the antimagic graph given a set threshold, at constant k and step d_k
  * The function modifies the labels of the graph provided in the params,
@@ -1062,74 +1439,15 @@ void printDetails(int failed, int method, Graph* g, int k, int l, int d_k,
  *
  * */
 Solver* attemptSolveWithThreshold(int method, Graph* g, int k, int l, int d_k,
-                                  int d_l, int precision, int* tabooPermutations,
+                                  int d_l, long precision, int* tabooPermutations,
                                   int sizePT) {
 
     Solver* s = createSolver(g);
-    printf("Attempting solve for %s with goal precision: %d\n", g->name, precision);
-
-    int i = 0;
-    float magicValue;
-    if (method == 0) {
-        magicValue = magicFormula(s, k, d_k);
-    } else if (method == 1) {
-        magicValue = magicFormulaRectangle(s, k, l, d_k, d_l);
-    } else if (method == 2) {
-        magicValue = magicFormulaUnknownConst(s);
-    } else if (method == 3) {
-        magicValue = antimagicFormulaKnownStep(s, d_k);
-    } else if (method == 4) {
-        magicValue = antimagicFormulaUnknownConst(s);
-    } else if (method == 5) {
-        magicValue = antimagicFormulaKnownConst(s, k);
-    } else if (method == 6) {
-        magicValue = allDifferentFormula(s);
-    }
-
-    while (magicValue > precision) {
-
-        showProgress(i, timeout);
-
-        if (i > timeout) {
-            printDetails(1, method, g, k, l, d_k, d_l, precision);
-            return NULL;
-        }
-
-        if (!bestGraphByVertex(method, s, k, l, d_k, d_l,
-                               tabooPermutations, sizePT)) {
-            if (!bestGraphByEdges(method, s, k, l, d_k, d_l,
-                                  tabooPermutations, sizePT)) {
-                if (!bestGraphByVerticesAndEdges(method, s, k, l, d_k, d_l,
-                                                 tabooPermutations, sizePT)) {
-
-                    newCloseGraph(s, tabooPermutations, sizePT);
-                }
-            }
-        }
-
-        attemptSolveVertexAndIssuedEdges(method, s, k, l, d_k, d_l, precision,
-                                         tabooPermutations, sizePT);
-
-        i++;
-
-        if (method == 0) {
-            magicValue = magicFormula(s, k, d_k);
-        } else if (method == 1) {
-            magicValue = magicFormulaRectangle(s, k, l, d_k, d_l);
-        } else if (method == 2) {
-            magicValue = magicFormulaUnknownConst(s);
-        } else if (method == 3) {
-            magicValue = antimagicFormulaKnownStep(s, d_k);
-        } else if (method == 4) {
-            magicValue = antimagicFormulaUnknownConst(s);
-        } else if (method == 5) {
-            magicValue = antimagicFormulaKnownConst(s, k);
-        } else if (method == 6) {
-            magicValue = allDifferentFormula(s);
-        }
+    if (!attemptSolveWithSolverAndThreshold(method, s, k, l, d_k, d_l, precision,
+                                            tabooPermutations, sizePT)) {
+        freeSolver(s, 0);
+        return NULL;
     }
-    printDetails(0, method, g, k, l, d_k, d_l, precision);
-
     return s;
 }
 
@@ -1156,25 +1474,13 @@ Solver* attemptSolve(int method, Graph* g, int k, int l, int d_k,
                                      permutationTaboues, sizePT);
 }
 
-/**
- * Checks if the rectangle is magic
- * @param s The solver containing the rectangle
- * @param u The column constant
- * @param v The line constant
- * @return 1 if the rectangle is magic, 0 if not
- */
-int isMagic_Rect(Solver* s, int u, int v) {
-    // Renvoit 1 si le graphe est magique
-    int res;
-    for (int i = 0; i < s->g->nbv; i++) {
-        res = (s->tab[i]->v->label);
-        for (int j = 0; j < s->tab[i]->size; j++) {
-            res += s->tab[i]->issuedEdges[j]->label;
-        }
-        if (s->tab[i]->v->name[1] == '0' && res != u) { return 0; }
-        if (s->tab[i]->v->name[1] == '1' && res != v) { return 0; }
+Solver* attemptSolveWithSolver(int method, Solver* s, int k, int l, int d_k,
+                               int d_l, int* permutationTaboues, int sizePT) {
+    if (!attemptSolveWithSolverAndThreshold(method, s, k, l, d_k, d_l, 0,
+                                            permutationTaboues, sizePT)) {
+        return NULL;
     }
-    return 1;
+    return s;
 }
 
 // -------- Public func ---------------
@@ -1196,6 +1502,136 @@ int getMaxMagicConst(Graph* g) {
     return (int)max;
 }
 
+/**
+ * @return The largest integer at most a / b, with b > 0
+ */
+long floorDiv(long a, long b) { return a >= 0 ? a / b : -((-a + b - 1) / b); }
+
+/**
+ * Bounds the smallest weight of a VAT of step d, or the constant of a VMT if d is 0,
+ * see mayHaveLabelling
+ * @param k The smallest weight, 0 if any
+ * @param d The step, at least 0
+ * @param degrees The smallest and the largest degrees of the graph
+ * @param reason Where the bounds that contradict each other are described
+ * @return 1 if an integer is within the bounds, 0 if not
+ */
+int boundSmallestWeight(Graph* g, long k, long d, int* degrees, char* reason) {
+    long n = g->nbv;
+    long m = g->nbe;
+    long nbl = n + m;
+    long spread = d * (n - 1);
+    // The sum of the weights is the sum of all the labels plus the labels of the
+    // edges, and the weights are a, a+d, ..., a+(n-1)d
+    long sum = nbl * (nbl + 1) / 2 - d * n * (n - 1) / 2;
+    // The lower bounds are at even indices, the upper ones at odd indices
+    long bounds[6] = {-floorDiv(-(sum + m * (m + 1) / 2), n),
+                      floorDiv(sum + m * (2 * nbl - m + 1) / 2, n)};
+    char* names[6] = {"the sum of the labels", "the sum of the labels",
+                      "a vertex of smallest degree", "a vertex of smallest degree",
+                      "a vertex of largest degree", "a vertex of largest degree"};
+    for (int t = 0; t < 2; t++) {
+        long r = degrees[t];
+        // The smallest weight is at most the weight of the vertex, the largest one at least
+        long lightest = (r + 1) * (r + 2) / 2;
+        long heaviest = (r + 1) * (2 * nbl - r) / 2;
+        bounds[2 + 2 * t] = t == 0 ? lightest : lightest - spread;
+        bounds[3 + 2 * t] = t == 0 ? heaviest : heaviest - spread;
+    }
+    int low = 0;
+    int high = 1;
+    for (int i = 2; i < 6; i += 2) {
+        if (bounds[i] > bounds[low]) { low = i; }
+        if (bounds[i + 1] < bounds[high]) { high = i + 1; }
+    }
+    char* what = d ? "the smallest weight" : "k";
+    if (k && (k < bounds[low] || k > bounds[high])) {
+        int i = k < bounds[low] ? low : high;
+        sprintf(reason, "%s = %ld, but %s %s %ld for %s", what, k, what,
+                i == low ? ">=" : "<=", bounds[i], names[i]);
+        return 0;
+    }
+    if (bounds[low] > bounds[high]) {
+        sprintf(reason, "%s >= %ld for %s, but %s <= %ld for %s", what, bounds[low],
+                names[low], what, bounds[high], names[high]);
+        return 0;
+    }
+    return 1;
+}
+
+int mayHaveLabelling(Graph* g, int k, int d, char* reason) {
+    if (!g->nbv) { return 1; }
+    int* tab = degreesTab(g);
+    int degrees[2] = {tab[0], tab[0]};
+    int isolated = 0;
+    for (int i = 0; i < g->nbv; i++) {
+        if (tab[i] < degrees[0]) { degrees[0] = tab[i]; }
+        if (tab[i] > degrees[1]) { degrees[1] = tab[i]; }
+        isolated += tab[i] == 0;
+    }
+    int* ends = malloc((2 * g->nbe + 1) * sizeof(int));
+    getEdgesEndpoints(g, ends);
+    int lonelyEdge = 0;
+    for (int i = 0; i < g->nbe; i++) {
+        lonelyEdge |= tab[ends[2 * i]] == 1 && tab[ends[2 * i + 1]] == 1;
+    }
+    free(ends);
+    free(tab);
+    // Their weights would be their labels, or their labels plus the same edge
+    int twins = isolated >= 2 || lonelyEdge;
+
+    if (d == 0 && twins) {
+        sprintf(reason, "two vertices %s, so they cannot have the same weight",
+                isolated >= 2 ? "are isolated" : "are only joined to each other");
+        return 0;
+    }
+    long n = g->nbv;
+    if (d != -1) {
+        // With a negative step, k is the largest weight
+        long smallest = k && d < 0 ? k + d * (n - 1) : k;
+        return boundSmallestWeight(g, smallest, labs(d), degrees, reason);
+    }
+
+    // Any step, at most the one spreading the weights from the lightest to the heaviest
+    long nbl = n + g->nbe;
+    long maxStep = n > 1 ? ((degrees[1] + 1L) * (2 * nbl - degrees[1]) / 2 -
+                            (degrees[0] + 1L) * (degrees[0] + 2) / 2) / (n - 1)
+                         : 0;
+    for (long step = twins; step <= maxStep; step++) {
+        if (boundSmallestWeight(g, k, step, degrees, reason)) { return 1; }
+    }
+    sprintf(reason, "no step in [%d, %ld] meets the bounds on the weights", twins, maxStep);
+    return 0;
+}
+
+int seedFromConstruction(Graph* known, int k, int* seed) {
+    Solver* s = createSolver(known);
+    int nbl = s->nbv + s->nbe;
+    int weights[s->nbv];
+    int res = 1;
+
+    // The construction must be a labeling with 1 to nbv+nbe
+    char* seen = calloc(nbl + 1, sizeof(char));
+    for (int i = 0; i < nbl && res; i++) {
+        if (s->labels[i] < 1 || s->labels[i] > nbl || seen[s->labels[i]]) { res = 0; }
+        else seen[s->labels[i]] = 1;
+    }
+    free(seen);
+
+    if (res && k && !isMagic(s, k)) {
+        // The complement of a VMT of a regular graph is a VMT with another constant
+        for (int i = 0; i < nbl; i++) {
+            s->labels[i] = nbl + 1 - s->labels[i];
+        }
+    }
+    getWeights(s, weights);
+    if (res && !isMagicUnknwonConst(s)) { res = 0; }
+    if (res && k && weights[0] != k) { res = 0; }
+    if (res) { memcpy(seed, s->labels, nbl * sizeof(int)); }
+    freeSolver(s, 0);
+    return res;
+}
+
 Graph* solveVmtWithConst(Graph* g, int k) {
     int min = getMinMagicConst(g);
     int max = getMaxMagicConst(g);
@@ -1211,7 +1647,7 @@ Graph* solveVmtWithConst(Graph* g, int k) {
     if (!s) return NULL;
     assert(isMagic(s, k));
     freeSolver(s, 0);
-    return s->g;
+    return g;
 }
 
 Graph* solveVmtWithConstTabu(Graph* g, int k, int* ignoredLabels) {
@@ -1234,7 +1670,7 @@ Graph* solveVmtWithConstTabu(Graph* g, int k, int* ignoredLabels) {
     if (!s) return NULL;
     assert(isMagic(s, k));
     freeSolver(s, 0);
-    return s->g;
+    return g;
 }
 
 Graph* solveVmt(Graph* g) {
@@ -1242,7 +1678,7 @@ Graph* solveVmt(Graph* g) {
     if (!s) return NULL;
     assert(isMagicUnknwonConst(s));
     freeSolver(s, 0);
-    return s->g;
+    return g;
 }
 
 void getAntiMagicMinConstAndMaxStep(Graph* g, float* a, float* d) {
@@ -1253,13 +1689,14 @@ void getAntiMagicMinConstAndMaxStep(Graph* g, float* a, float* d) {
         if (v->size < min_deg) min_deg = v->size;
         if (v->size > max_deg) max_deg = v->size;
         if (min_deg == -1) min_deg = v->size;
+        freeIssuedEdges(v);
     }
     *a = ((min_deg + 1) * (min_deg + 2)) / 2.f;
     int n = g->nbv;
     int m = g->nbe;
     *d = ((2 * n + 2 * m - max_deg) * (max_deg + 1) -
           (min_deg + 1) * (min_deg + 2)) /
-         2.f * (n - 1);
+         (2.f * (n - 1));
     return;
 }
 
@@ -1281,20 +1718,20 @@ Graph* solveVatWithConstAndStep(Graph* g, int a, int step) {
     Solver* s = attemptSolveWithThreshold(0, g, a, 0, step, 0, 0, NULL, 0);
     if (!s) return NULL;
     freeSolver(s, 0);
-    return s->g;
+    return g;
 }
 
 Graph* solveVatWithstep(Graph* g, int a) {
     Solver* s = attemptSolveWithThreshold(3, g, 0, 0, a, 0, 0, NULL, 0);
     if (!s) return NULL;
     freeSolver(s, 0);
-    return s->g;
+    return g;
 }
 Graph* solveVat(Graph* g) {
     Solver* s = attemptSolveWithThreshold(4, g, 0, 0, 0, 0, 0, NULL, 0);
     if (!s) return NULL;
     freeSolver(s, 0);
-    return s->g;
+    return g;
 }
 
 Rectangle* solveMagicRect(Rectangle* r, int* cst_width, int* cst_height) {
@@ -1306,11 +1743,10 @@ Rectangle* solveMagicRect(Rectangle* r, int* cst_width, int* cst_height) {
     if (cst_width) *cst_width = width_c;
     if (cst_height) *cst_height = height_c;
 
-    Solver* s =
-        attemptSolveWithThreshold(1, r->g, height_c, width_c, 0, 0, 0, NULL, 0);
-    if (!s) return NULL;
-    assert(isMagic_Rect(s, width_c, height_c));
-    freeSolver(s, 0);
+    RectangleSolver* rs = createRectangleSolver(r, height_c, width_c, 0, 0);
+    int solved = attemptSolveRectangle(rs);
+    freeRectangleSolver(rs);
+    if (!solved) return NULL;
     updateRectangle(r);
     return r;
 }
@@ -1328,10 +1764,91 @@ Rectangle* solveAntiMagicRect(Rectangle* r, int width_step, int height_step,
     if (cst_width) *cst_width = width_c;
     if (cst_height) *cst_height = height_c;
 
-    Solver* s = attemptSolveWithThreshold(1, r->g, height_c, width_c, height_step,
-                                          width_step, 0, NULL, 0);
-    if (!s) return NULL;
-    freeSolver(s, 0);
+    RectangleSolver* rs =
+        createRectangleSolver(r, height_c, width_c, height_step, width_step);
+    int solved = attemptSolveRectangle(rs);
+    freeRectangleSolver(rs);
+    if (!solved) return NULL;
     updateRectangle(r);
     return r;
 }
+
+long localSearch(int method, Solver* s, int k, int l, int d_k, int d_l,
+                 long precision, int* tabooPermutations, int sizePT) {
+    long magicValue = objective(method, s, k, l, d_k, d_l);
+    while (magicValue > precision) {
+        int improved = bestGraphByVertex(method, s, k, l, d_k, d_l, tabooPermutations, sizePT) ||
+                       bestGraphByEdges(method, s, k, l, d_k, d_l, tabooPermutations, sizePT) ||
+                       bestGraphByVerticesAndEdges(method, s, k, l, d_k, d_l,
+                                                   tabooPermutations, sizePT);
+        attemptSolveVertexAndIssuedEdges(method, s, k, l, d_k, d_l, precision,
+                                         tabooPermutations, sizePT);
+        long newValue = objective(method, s, k, l, d_k, d_l);
+        if (!improved && newValue >= magicValue) { return newValue; }
+        magicValue = newValue;
+    }
+    return magicValue;
+}
+
+Solver* attemptSolveIls(int method, Solver* s, int k, int l, int d_k, int d_l,
+                        int* tabooPermutations, int sizePT) {
+    // The kicks get one swap stronger every STAGNATION_STEP kicks without improvement
+    const int STAGNATION_STEP = 10;
+    int nbl = s->nbv + s->nbe;
+    Graph* g = s->g;
+    printf("Attempting iterated local search for %s\n", g->name);
+
+    long best = localSearch(method, s, k, l, d_k, d_l, 0, tabooPermutations, sizePT);
+    memcpy(s->bestLabels, s->labels, nbl * sizeof(int));
+
+    int kicks = 0;
+    int consecutiveKicks = 0;
+    int improvements = 0;
+    int stagnation = 0;
+    int maxStagnation = 0;
+    int strength = 1;
+    int maxStrength = 1;
+    while (best > 0 && kicks < timeout) {
+        showProgress(kicks, timeout);
+        strength = 1 + stagnation / STAGNATION_STEP;
+        if (strength > nbl / 2) {
+            // Kicks this strong are random restarts, we go back to small ones
+            stagnation = 0;
+            strength = 1;
+        }
+        if (strength > maxStrength) { maxStrength = strength; }
+
+        memcpy(s->labels, s->bestLabels, nbl * sizeof(int));
+        indexLabels(s);
+        if (sizePT == 0 && rand() % 2) {
+            for (int i = 0; i < strength; i++) {
+                newVeryCloseGraph(s, 1);
+            }
+            consecutiveKicks++;
+        } else {
+            perturbSolver(s, strength, tabooPermutations, sizePT);
+        }
+        kicks++;
+
+        long value = localSearch(method, s, k, l, d_k, d_l, 0, tabooPermutations, sizePT);
+        if (value < best) {
+            best = value;
+            memcpy(s->bestLabels, s->labels, nbl * sizeof(int));
+            improvements++;
+            stagnation = 0;
+        } else {
+            stagnation++;
+            if (stagnation > maxStagnation) { maxStagnation = stagnation; }
+        }
+    }
+    showProgress(timeout, timeout);
+
+    memcpy(s->labels, s->bestLabels, nbl * sizeof(int));
+    indexLabels(s);
+    writeSolver(s);
+    printDetails(best > 0, method, g, k, l, d_k, d_l, 0);
+    printf("%d kicks (%d on consecutive labels), %d improvements, "
+           "longest stagnation of %d kicks, strongest kick of %d swaps\n",
+           kicks, consecutiveKicks, improvements, maxStagnation, maxStrength);
+    return best > 0 ? NULL : s;
+}
@@ -4,12 +4,94 @@
 #include "Rectangle.h"
 #include <stdio.h>
 
+/**
+ * The structure of the graph of a solver, which the searches never modify.
+ * The solvers of the threads working on the same graph share it, see shareSolver
+ */
+typedef struct _topology {
+    // The endpoints of the edge i are ends[2i] and ends[2i+1]
+    int* ends;
+    // The edges issued from the vertex i are incidence[offsets[i]] to incidence[offsets[i+1]-1]
+    int* offsets;
+    int* incidence;
+    // 1 if g is a complete graph with its edges in lexicographic order, see weightsComplete
+    int complete;
+    // 1 if two edges have the same endpoints
+    int parallelEdges;
+    int maxNbv;
+    int maxNbe;
+    // The number of solvers sharing it, the last one frees it
+    int users;
+} Topology;
+
+/**
+ * A solver works on its own copy of the labels of a graph.
+ * The elements are indexed with the vertices first, then the edges:
+ * the label of the vertex i is labels[i] and the one of the edge j is labels[nbv + j]
+ *
+ * The buffers are sized for the largest graph the solver was bound to,
+ * so the same solver can be reused for many attempts and many graphs.
+ */
 typedef struct _solver {
     Graph* g;
-    IssuedEdges** tab;
+    int nbv;
+    int nbe;
+    int* labels;
+    // The labels of g when the solver was bound to it
+    int* initialLabels;
+    // The best labels found by the searches that restart from them
+    int* bestLabels;
+    // The element holding each label, -1 for the unused ones, see indexLabels
+    int* positions;
+    int nbPositions;
+    Topology* topology;
+    // The weights of the vertices and their sums, see prepareSwapScore
+    int* weights;
+    long weightSum;
+    long weightSquares;
+    long weightDistance;
+    int scoreK;
+    long score;
+    // 1 if the swaps are scored against a bound, from the weights in the order of
+    // the terms of the objective and the ranks of the largest terms first
+    int bounded;
+    int* sortedWeights;
+    int weightOrder;
+    int* termOrder;
+    int maxNbv;
+    int maxNbe;
 
 } Solver;
 
+/**
+ * Creates a solver bound to g
+ *
+ * @param 	g the graph to solve
+ * @return 	The allocated solver
+ */
+Solver* createSolver(Graph* g);
+
+/**
+ * Creates a solver for the same graph that shares the topology of s, and only
+ * allocates its own labels and weights. The threads of a search on one graph
+ * each use one, s must be freed after them or bound to another graph
+ *
+ * @param 	s the solver whose graph is solved
+ * @return 	The allocated solver, with the current labels of s
+ */
+Solver* shareSolver(Solver* s);
+
+/**
+ * Binds the solver to another graph, in O(n+m).
+ * The buffers are only reallocated if g is larger than all the graphs seen before.
+ * The current labels of g are kept, so that every attempt can start from them.
+ * A topology shared with other solvers is left to them, a new one is allocated
+ *
+ * @param 	s the solver
+ * @param 	g the graph to solve
+ */
+void bindSolver(Solver* s, Graph* g);
+
 /**
  * Free the allocated memory of a solver
  *
@@ -19,6 +101,64 @@ typedef struct _solver {
 
 void freeSolver(Solver* s, int freeG);
 
+/**
+ * Restores the labels the graph had when the solver was bound to it.
+ * It does not allocate anything, so it can be used before each attempt
+ *
+ * @param 	s the solver
+ */
+void resetSolver(Solver* s);
+
+/**
+ * Rebuilds the position of each label, in O(n+m). It must be called after the
+ * labels are copied as a whole, the swaps keep the positions up to date
+ *
+ * @param 	s the solver
+ */
+void indexLabels(Solver* s);
+
+/**
+ * Swaps the labels of two elements and updates their positions
+ *
+ * @param 	s the solver
+ * @param 	a the first element
+ * @param 	b the second element
+ */
+void swapLabels(Solver* s, int a, int b);
+
+/**
+ * Randomly permutes all the labels of the solver
+ *
+ * @param 	s the solver
+ */
+void shuffleSolver(Solver* s);
+
+/**
+ * Swaps random pairs of labels of the solver, without moving the taboo ones
+ *
+ * @param 	s the solver
+ * @param 	strength the number of random swaps
+ * @param 	tabooPermutations List of label that will not be permuted, NULL if ignored
+ * @param 	sizePT The size of the provided list, 0 if ignored
+ */
+void perturbSolver(Solver* s, int strength, int* tabooPermutations, int sizePT);
+
+/**
+ * Copies the labels of the solver in its graph
+ *
+ * @param 	s the solver
+ */
+void writeSolver(Solver* s);
+
+/**
+ * Computes the weight of every vertex, that is the sum of its label
+ * and the labels of its issued edges
+ *
+ * @param 	s the solver
+ * @param 	weights the table of size nbv to fill
+ */
+void getWeights(Solver* s, int* weights);
+
 /**
  * Finds the antimagic graph at constant k and step d_k
  * The function modifies the labels of the graph provided in the params,
@@ -40,6 +180,14 @@ void freeSolver(Solver* s, int freeG);
  * */
 Solver* attemptSolve(int method, Graph* g, int k, int l, int d_k, int d_l, int* permutationsTaboues, int sizePT);
 
+/**
+ * Same as attemptSolve, but reuses the given solver instead of creating one.
+ * The attempt starts from the current labels of the solver
+ *
+ * @return 	s if the solution was found, NULL if not
+ * */
+Solver* attemptSolveWithSolver(int method, Solver* s, int k, int l, int d_k, int d_l, int* permutationsTaboues, int sizePT);
+
 // Solveur* GenererGrapheMagiqueCompletP(int nbVertex, int k, float precision);
 // Solveur* GenererGrapheMagiqueComplet(int nbVertex, int k);
 
@@ -56,6 +204,24 @@ int getMinMagicConst(Graph* g);
  * */
 int getMaxMagicConst(Graph* g);
 
+/**
+ * Cheap necessary conditions for a VMT or a VAT to exist, checked before a search:
+ * - the sum of the weights is the sum of all the labels plus the sum of the labels
+ * of the edges, so it is bounded, and it must be reached with weights in steps of d
+ * - a vertex of degree r has a weight between the sum of the r+1 smallest labels
+ * and the sum of the r+1 largest ones, this bounds the smallest and the largest
+ * weights with the smallest and largest degrees, an isolated vertex in particular
+ * - two vertices with the same edges, isolated or joined by an edge of their own,
+ * cannot have the same weight in a VMT
+ *
+ * @param 	g The graph
+ * @param 	k The constant of the VMT or the smallest weight of the VAT, 0 if any
+ * @param 	d The step of the VAT, 0 for a VMT, -1 for any step
+ * @param 	reason Where the condition that fails is described, BUFFER_SIZE characters
+ * @return 	1 if a labelling may exist, 0 if none can
+ */
+int mayHaveLabelling(Graph* g, int k, int d, char* reason);
+
 /**
  * Calculates the magic constant of a VMT
  * @param g A graph
@@ -134,3 +300,130 @@ Rectangle* solveMagicRect(Rectangle* r, int* cst_width, int* cst_height);
  * */
 Rectangle* solveAntiMagicRect(Rectangle* r, int width_step, int height_step,
                               int* cst_width, int* cst_height);
+
+/**
+ * Gets the labels of a known VMT construction, to start an attempt from them.
+ * If the constant of the construction is not k, the complement of its labels
+ * x -> nbv+nbe+1-x is tried, which is also a VMT when the graph is regular.
+ * The construction is checked before being used
+ *
+ * @param known The labeled construction, with the same elements in the same
+ * order as the graph to solve
+ * @param k The wanted magic constant, 0 for any
+ * @param seed The table of size nbv+nbe to fill, vertices first then edges
+ * @return 1 if seed was filled with a k-VMT, 0 if not
+ */
+int seedFromConstruction(Graph* known, int k, int* seed);
+
+/**
+ * Get the heuristic of the current graph for the chosen method
+ * @param method 0 to solve an antimagic graph (k, d_k),
+ * 1 to solve an antimagic (k, d_k), (l, d_l) rectangle,
+ * 2 to find a VMT
+ * 3 to find a VAT knowing a step
+ * 4 to find a VAT
+ * 5 to find a VAT knowing its constant
+ * 6 to find a labelling where all the weights are different
+ *
+ * @param s The solver to study
+ * @param k Depends on the method, can be ignored
+ * @param l Depends on the method, can be ignored
+ * @param d_k Depends on the method, can be ignored
+ * @param d_l Depends on the method, can be ignored
+ * @return 0 if the graph is solved
+ */
+long objective(int method, Solver* s, int k, int l, int d_k, int d_l);
+
+/**
+ * Prepares the scoring of swaps in constant time. A swap only changes the weights
+ * of the endpoints of the two elements, at most 4 vertices, and the VMT objectives
+ * only depend on the sum of the weights, of their squares or of their distances to k.
+ * The weights and these sums are stored in the solver, and score is set to the
+ * objective of the current labels.
+ *
+ * The other objectives on the sorted weights are bounded by the best swap found
+ * so far instead. The sorted weights are stored, a swap only moves at most 4 of
+ * them, and the ranks whose terms are the largest for the current labels are
+ * summed first: a swap rarely changes them, so a worse swap is discarded after
+ * a few terms
+ *
+ * @param 	method the objective, see attemptSolveWithSolver
+ * @param 	s the solver
+ * @param 	k The magic constant, used by the method 0
+ * @param 	d_k The step, the method 0 is only supported without step
+ * @return 	1 if swapScore can be used for this method, 0 if not
+ */
+int prepareSwapScore(int method, Solver* s, int k, int d_k);
+
+/**
+ * Scores the swap of two labels in constant time, without swapping them.
+ * prepareSwapScore must have been called on the current labels
+ *
+ * @param 	method the objective given to prepareSwapScore
+ * @param 	s the solver
+ * @param 	a The index of the first element, vertices first then edges
+ * @param 	b The index of the second element
+ * @return 	The objective after the swap
+ */
+long swapScore(int method, Solver* s, int a, int b);
+
+/**
+ * One step of the cascade of attemptSolveWithSolver: the best permutation of
+ * two vertices, else of two edges, else of a vertex and an edge is applied,
+ * or a random one if none of them improves the labels. Then the vertices are
+ * permuted with their issued edges until it does not improve anymore
+ *
+ * @param 	method the objective, see attemptSolveWithSolver
+ * @param 	s the solver, whose labels are modified
+ * @param 	k Depends on the method, can be ignored
+ * @param 	l Depends on the method, can be ignored
+ * @param 	d_k Depends on the method, can be ignored
+ * @param 	d_l Depends on the method, can be ignored
+ * @param 	precision the value of the objective to reach, 0 to solve the graph
+ * @param 	tabooPermutations List of label that will not be permuted, NULL if ignored
+ * @param 	sizePT The size of the provided list, 0 if ignored
+ */
+void cascadeStep(int method, Solver* s, int k, int l, int d_k, int d_l,
+                 long precision, int* tabooPermutations, int sizePT);
+
+/**
+ * Applies the cascade of permutations until none of them improves the labels,
+ * without any random permutation
+ * @return The value of the objective at the local optimum
+ */
+long localSearch(int method, Solver* s, int k, int l, int d_k, int d_l,
+                 long precision, int* tabooPermutations, int sizePT);
+
+/**
+ * Iterated local search: the cascade of permutations is applied until it reaches
+ * a local optimum, then the best labels found so far are kicked with random swaps,
+ * and so on. The longer the search stagnates, the more swaps a kick does.
+ * Half of the kicks swap consecutive labels instead, when there is no taboo label.
+ * Statistics about the stagnation and the kicks are printed at the end
+ *
+ * @param 	method the objective, see attemptSolveWithSolver
+ * @param 	s the solver, the attempt starts from its current labels
+ * @param 	k Depends on the method, can be ignored
+ * @param 	l Depends on the method, can be ignored
+ * @param 	d_k Depends on the method, can be ignored
+ * @param 	d_l Depends on the method, can be ignored
+ * @param 	tabooPermutations List of label that will not be permuted, NULL if ignored
+ * @param 	sizePT The size of the provided list, 0 if ignored
+ * @return 	s if a solution was found in at most timeout kicks, NULL if not
+ */
+Solver* attemptSolveIls(int method, Solver* s, int k, int l, int d_k, int d_l,
+                        int* tabooPermutations, int sizePT);
+
+/**
+ * Logs the result of the solve attempt
+ * @param failed 1 to log a failed operation
+ * @param method 0 to log a graph operation, 1 to log a rectangle operation
+ * @param g The graph on wich we log operation
+ * @param k The goal constant, in method 1 for the columns
+ * @param l The line constant, in method 0 this is ignored
+ * @param d_k The antimagic step, in method 1 for the columns
+ * @param d_l The antimagic step for lines, in method 0 this is ignored
+ * @param precision Target precision
+ */
+void printDetails(int failed, int method, Graph* g, int k, int l, int d_k,
+                  int d_l, long precision);
@@ -1,11 +1,19 @@
+#include "Cache.h"
 #include "Editor.h"
+#include "Exact.h"
 #include "Graph.h"
 #include "GraphParser.h"
+#include "HashSet.h"
 #include "Rectangle.h"
 #include "Solver.h"
+#include "Stats.h"
+#include "Symmetry.h"
+#include "Portfolio.h"
+#include "Tempering.h"
 #include "Utils.h"
 
 #include <ctype.h>
+#include <getopt.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -33,7 +41,370 @@ Parameters c, a and r are incompatible together\n\
      -S    : The step of the VAT. If not precised, it solves a VMT. If -1, it will find any possible step\n\
      -D    : Found a labelling where all the weights are different\n\
      -T    : The label values that are not permited to permute. Expected option : all the concerned labels separated by spaces \n\
+     -x    : Use the exact solver: finds a solution or proves that none exists. Only for small graphs (at most 63 labels). Incompatible with -T\n\
+     -j    : Number of threads of the exact solver. Expected option: an integer. Default is the number of processors\n\
+     --sweep-M : Solve a VMT for every feasible magic constant, and print which ones were found. -n is the number of tries for each constant\n\
+     --sweep-S : Solve a VAT for every feasible step, and print which ones were found. -n is the number of tries for each step\n\
+     --warm : Restart every try from the labels of the dot file, with more and more random swaps. Incompatible with -l\n\
+     --ils : Use an iterated local search with kicks that grow while the search stagnates. -t is the maximum number of kicks\n\
+     --portfolio : Split the threads (-j, at least 4) between the cascade, simulated annealing, tabu search and iterated local search, sharing their best labels. -t is the maximum number of steps of each thread\n\
+     --tempering : Use parallel tempering, with one replica per thread (-j). -t is the maximum number of sweeps of each replica\n\
+     --unique : Only keep the solutions that are new up to automorphisms and label complement, and report the discovery rate\n\
+     --stats-only : Print a table of statistics of every graph of the file (-f) without solving them, on -j threads\n\
+     --cache : Look the graph up in a cache file before solving it, and record the result there. Expected option : the name of the file. Graphs isomorphic to a cached one are found too\n\
 See README for examples and better details\n"
+/**
+ * The parameters of the command line describing what to solve on a graph,
+ * and what to do with the solutions
+ */
+typedef struct _options {
+    int nb;
+    int relabel;
+    int print;
+    char* directory;
+    int diff;
+    int magicConstant;
+    int step;
+    int* taboo;
+    int tabooSize;
+    int exact;
+    int threads;
+    int unique;
+    // The labels of a known solution to start the first attempt from, NULL if none
+    int* seed;
+    // SWEEP_M or SWEEP_S to solve for all the constants or steps, 0 if not
+    int sweep;
+    int warm;
+    int ils;
+    int tempering;
+    int portfolio;
+    // The solved and failed instances of previous runs, NULL if none
+    SolutionCache* cache;
+} Options;
+
+#define SWEEP_M 1
+#define SWEEP_S 2
+
+/**
+ * Finds the objective matching the options
+ * @param o The options of the command line
+ * @param method Where to store the method of the objective, see attemptSolveWithSolver
+ * @param k Where to store the constant of the objective
+ * @param d Where to store the step of the objective
+ */
+void getObjective(Options* o, int* method, int* k, int* d) {
+    *k = 0;
+    *d = 0;
+    if (o->diff) {
+        *method = 6;
+    } else if (o->step == 0) {
+        *method = o->magicConstant ? 0 : 2;
+        *k = o->magicConstant;
+    } else if (o->step == -1) {
+        *method = o->magicConstant ? 5 : 4;
+        *k = o->magicConstant;
+    } else {
+        *method = o->magicConstant ? 0 : 3;
+        *k = o->magicConstant;
+        *d = o->step;
+    }
+}
+
+/**
+ * Launches one attempt with the objective matching the options
+ * @param s The solver to use, the attempt starts from the labels of s->g
+ * @param o The options of the command line
+ * @return s if a solution was found, NULL if not
+ */
+Solver* solveOnce(Solver* s, Options* o) {
+    int method;
+    int k;
+    int d;
+    getObjective(o, &method, &k, &d);
+    if (o->portfolio) {
+        return attemptSolvePortfolio(method, s, k, 0, d, 0, o->threads, o->taboo,
+                                     o->tabooSize);
+    }
+    if (o->tempering) {
+        return attemptSolveTempering(method, s, k, 0, d, 0, 0, o->threads, o->taboo,
+                                     o->tabooSize);
+    }
+    if (o->ils) {
+        return attemptSolveIls(method, s, k, 0, d, 0, o->taboo, o->tabooSize);
+    }
+    return attemptSolveWithSolver(method, s, k, 0, d, 0, o->taboo, o->tabooSize);
+}
+
+/**
+ * Prints and saves the solution found, according to the options
+ * @param s The solver that found the solution
+ * @param name The name of the graph to use in the dot file name
+ * @param cpt The number of the attempt
+ * @param o The options of the command line
+ */
+void outputSolution(Solver* s, char* name, int cpt, Options* o) {
+    char buff[BUFFER_SIZE];
+    int a = 0;
+    int d = 0;
+    if (o->print) { printGraph(s->g); }
+    if (!o->directory) { return; }
+    if (o->diff) {
+        sprintf(buff, "%s/Graph_%s_n%d.dot", o->directory, name, cpt);
+    } else if (o->step == 0) {
+        sprintf(buff, "%s/Graph_%s_%d-VMT_n%d.dot", o->directory, name,
+                getMagicConst(s->g), cpt);
+    } else {
+        getAntimagicConst(s, &a, &d);
+        sprintf(buff, "%s/Graph_%s_(%d,%d)-VAT_n%d.dot", o->directory, name, a,
+                d, cpt);
+    }
+    generateDotFile(buff, s->g, 0);
+}
+
+/**
+ * @param o The options of the command line
+ * @return The search of the options, failures are only shared between the same searches
+ */
+int searchOf(Options* o) {
+    if (o->exact) { return 4; }
+    if (o->portfolio) { return 3; }
+    if (o->tempering) { return 2; }
+    return o->ils;
+}
+
+/**
+ * Answers the instance from the cache, if a previous run solved it, proved it
+ * impossible, or failed with at least the budget of this one. A cached solution
+ * is checked before it is used
+ * @param s The solver bound to the graph to solve
+ * @param name The name of the graph to use in the dot file name
+ * @param key The key of the instance
+ * @param o The options of the command line
+ * @return 1 if the instance was answered, 0 if it has to be solved
+ */
+int answerFromCache(Solver* s, char* name, CacheKey* key, Options* o) {
+    int nbl = s->nbv + s->nbe;
+    int method;
+    int k;
+    int d;
+    int attempts;
+    int sweeps;
+    getObjective(o, &method, &k, &d);
+    int status = lookupCache(o->cache, key, s->labels, &attempts, &sweeps);
+
+    if (status == CACHE_SOLVED) {
+        int valid = 1;
+        int* seen = calloc(nbl + 1, sizeof(int));
+        for (int i = 0; i < nbl && valid; i++) {
+            valid = s->labels[i] >= 1 && s->labels[i] <= nbl && !seen[s->labels[i]]++;
+            if (inTab(s->initialLabels[i], o->taboo, o->tabooSize)) {
+                valid &= s->labels[i] == s->initialLabels[i];
+            }
+        }
+        free(seen);
+        if (valid && objective(method, s, k, 0, d, 0) == 0) {
+            printf(ANSI_COLOR_GREEN "Found a solution of %s in the cache" ANSI_RESET_ALL "\n", name);
+            writeSolver(s);
+            outputSolution(s, name, 1, o);
+            return 1;
+        }
+        printf(ANSI_COLOR_YELLOW "Ignored a wrong solution of %s in the cache" ANSI_RESET_ALL "\n",
+               name);
+        resetSolver(s);
+        return 0;
+    }
+    if (status == CACHE_IMPOSSIBLE) {
+        printf(ANSI_COLOR_RED "No labelling of %s: proved by the exact solver in a previous run"
+               ANSI_RESET_ALL "\n", name);
+        return 1;
+    }
+    if (status == CACHE_FAILED && attempts >= o->nb && sweeps >= timeout) {
+        printf(ANSI_COLOR_RED "%s was not solved in %d attempts of %d sweeps in a previous run"
+               ANSI_RESET_ALL "\n", name, attempts, sweeps);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Solves the graph for every feasible magic constant (SWEEP_M) or every step of
+ * VAT (SWEEP_S), with at most o->nb attempts for each, then prints which ones
+ * were found. The solution of a value is the start of the first attempt of the
+ * next one, since it is close to a solution for it
+ * @param s The solver bound to the graph to solve
+ * @param name The name of the graph to use in the dot file name
+ * @param relabel 1 to randomly relabel the graph before each attempt
+ * @param o The options of the command line
+ */
+void sweepConstants(Solver* s, char* name, int relabel, Options* o) {
+    int nbl = s->nbv + s->nbe;
+    int min = 1;
+    int max = 0;
+    if (o->sweep == SWEEP_M) {
+        min = getMinMagicConst(s->g);
+        max = getMaxMagicConst(s->g);
+    } else {
+        float a = 0;
+        float d = 0;
+        getAntiMagicMinConstAndMaxStep(s->g, &a, &d);
+        max = (int)d;
+    }
+    int count = max >= min ? max - min + 1 : 0;
+    int* found = calloc(count + 1, sizeof(int));
+    int* warm = malloc(nbl * sizeof(int));
+    int hasWarm = 0;
+    // The reasons of the values rejected before any attempt, empty for the others
+    char (*reasons)[BUFFER_SIZE] = calloc(count + 1, sizeof(*reasons));
+
+    for (int v = min; v <= max; v++) {
+        Options current = *o;
+        if (o->sweep == SWEEP_M) {
+            current.magicConstant = v;
+        } else {
+            current.step = v;
+        }
+        if (!mayHaveLabelling(s->g, current.magicConstant, current.step, reasons[v - min])) {
+            continue;
+        }
+        reasons[v - min][0] = '\0';
+        for (int cpt = 1; cpt < o->nb + 1; cpt++) {
+            resetSolver(s);
+            if (cpt == 1 && hasWarm) {
+                memcpy(s->labels, warm, nbl * sizeof(int));
+                indexLabels(s);
+            } else if (relabel) {
+                shuffleSolver(s);
+            }
+            if (!solveOnce(s, &current)) { continue; }
+            found[v - min] = cpt;
+            memcpy(warm, s->labels, nbl * sizeof(int));
+            hasWarm = 1;
+            outputSolution(s, name, cpt, &current);
+            break;
+        }
+    }
+
+    int solved = 0;
+    printf("%s %s of %s:\n", o->sweep == SWEEP_M ? "Magic constants" : "Steps",
+           o->sweep == SWEEP_M ? "k" : "d", name);
+    for (int v = min; v <= max; v++) {
+        if (found[v - min]) {
+            solved++;
+            printf(ANSI_COLOR_GREEN "  %s = %d : solved at attempt %d" ANSI_RESET_ALL "\n",
+                   o->sweep == SWEEP_M ? "k" : "d", v, found[v - min]);
+        } else if (reasons[v - min][0]) {
+            printf(ANSI_COLOR_RED "  %s = %d : impossible, %s" ANSI_RESET_ALL "\n",
+                   o->sweep == SWEEP_M ? "k" : "d", v, reasons[v - min]);
+        } else {
+            printf(ANSI_COLOR_RED "  %s = %d : no solution found in %d attempts" ANSI_RESET_ALL "\n",
+                   o->sweep == SWEEP_M ? "k" : "d", v, o->nb);
+        }
+    }
+    printf("%d of the %d values in [%d, %d] were solved\n", solved, count, min, max);
+    free(found);
+    free(warm);
+    free(reasons);
+}
+
+/**
+ * Makes all the attempts on the graph the solver is bound to.
+ * Every attempt starts again from the labels the graph had when the solver was
+ * bound, so nothing is allocated between attempts
+ * @param s The solver bound to the graph to solve
+ * @param name The name of the graph to use in the dot file name
+ * @param relabel 1 to randomly relabel the graph before each attempt
+ * @param o The options of the command line
+ * @return 0 if the graph cannot have the labelling asked for, so nothing was attempted, 1 if not
+ */
+int solveAttempts(Solver* s, char* name, int relabel, Options* o) {
+    if (o->sweep) {
+        sweepConstants(s, name, relabel, o);
+        return 1;
+    }
+    char reason[BUFFER_SIZE];
+    if (!o->diff && !mayHaveLabelling(s->g, o->magicConstant, o->step, reason)) {
+        printf(ANSI_COLOR_RED "No labelling of %s: %s" ANSI_RESET_ALL "\n", name, reason);
+        return 0;
+    }
+    // Relabelled frozen labels are not where the key has them
+    CacheKey* key = NULL;
+    if (o->cache && !(relabel && o->tabooSize)) {
+        int method;
+        int k;
+        int d;
+        getObjective(o, &method, &k, &d);
+        key = createCacheKey(s->g, method, k, d, searchOf(o), s->initialLabels, o->taboo,
+                             o->tabooSize);
+        if (answerFromCache(s, name, key, o)) {
+            freeCacheKey(key);
+            return 1;
+        }
+    }
+    if (o->exact) {
+        // The search is exhaustive, another attempt would give the same result
+        int res = solveExact(s->g, o->magicConstant, o->step, o->threads, NULL);
+        if (res == 1) {
+            getLabels(s->g, s->labels);
+            outputSolution(s, name, 1, o);
+        }
+        if (key && res != -1) {
+            storeCache(o->cache, key, res ? CACHE_SOLVED : CACHE_IMPOSSIBLE, s->labels, 1, 0);
+        }
+        if (key) { freeCacheKey(key); }
+        return 1;
+    }
+    HashSet* seen = NULL;
+    int solved = 0;
+    int lastDistinct = 0;
+    int window = o->nb / 10 > 0 ? o->nb / 10 : 1;
+    if (o->unique) {
+        seen = createHashSet(o->nb);
+        // The distinct solutions are counted up to these automorphisms
+        Symmetry* sym = computeSymmetry(s->g, NULL);
+        printf(ANSI_COLOR_CYAN "%s: %.0f automorphisms, generated by %d of them" ANSI_RESET_ALL "\n",
+               name, groupOrder(sym), sym->nbGenerators);
+        freeSymmetry(sym);
+    }
+
+    for (int cpt = 1; cpt < o->nb + 1; cpt++) {
+        resetSolver(s);
+        if (cpt == 1 && o->seed) {
+            printf("Starting %s from a known construction\n", name);
+            memcpy(s->labels, o->seed, (s->nbv + s->nbe) * sizeof(int));
+            indexLabels(s);
+        } else if (o->warm) {
+            // The further we get, the further from the saved labels we restart
+            if (cpt > 1) {
+                printf("Restarting %s from its labels with %d random swaps\n", name, cpt - 1);
+            }
+            perturbSolver(s, cpt - 1, o->taboo, o->tabooSize);
+        } else if (relabel) {
+            shuffleSolver(s);
+        }
+        if (solveOnce(s, o)) {
+            if (key && !solved) { storeCache(o->cache, key, CACHE_SOLVED, s->labels, cpt, timeout); }
+            solved++;
+            if (!seen || insertHashSet(seen, hashLabeling(s->g))) {
+                outputSolution(s, name, cpt, o);
+            }
+        }
+        // The discovery rate tells when new attempts are unlikely to find new solutions
+        if (seen && (cpt % window == 0 || cpt == o->nb)) {
+            int last = cpt % window == 0 ? window : cpt % window;
+            printf(ANSI_COLOR_CYAN "%s: %d attempts, %d solutions, %d distinct, "
+                   "%d new in the last %d attempts" ANSI_RESET_ALL "\n",
+                   name, cpt, solved, seen->size, seen->size - lastDistinct, last);
+            lastDistinct = seen->size;
+        }
+    }
+    if (seen) { freeHashSet(seen); }
+    if (key) {
+        if (!solved) { storeCache(o->cache, key, CACHE_FAILED, NULL, o->nb, timeout); }
+        freeCacheKey(key);
+    }
+    return 1;
+}
+
 int main(int argc, char** argv) {
 
     srand(time(NULL));
@@ -62,16 +433,62 @@ int main(int argc, char** argv) {
     int magic_constant = 0;
     int step = 0;
     int relabelFlag = 0;
-    char c;
+    int c;
     int* taboo = NULL;
     int taboo_size = 0;
-    int a = 0;
-    int d = 0;
+    int exactFlag = 0;
+    int uniqueFlag = 0;
+    int sweep = 0;
+    int warmFlag = 0;
+    int ilsFlag = 0;
+    int temperingFlag = 0;
+    int portfolioFlag = 0;
+    int statsFlag = 0;
+    char* cacheFile = NULL;
+    int threads = sysconf(_SC_NPROCESSORS_ONLN);
 
     char buff[BUFFER_SIZE];
 
-    while ((c = getopt(argc, argv, "her:a:c:f:s:pn:M:S:lDt:T:")) != -1)
+    static struct option longOptions[] = {{"unique", no_argument, NULL, 'u'},
+                                          {"sweep-M", no_argument, NULL, 'm'},
+                                          {"sweep-S", no_argument, NULL, 'd'},
+                                          {"warm", no_argument, NULL, 'w'},
+                                          {"ils", no_argument, NULL, 'i'},
+                                          {"tempering", no_argument, NULL, 'P'},
+                                          {"portfolio", no_argument, NULL, 'F'},
+                                          {"stats-only", no_argument, NULL, 'G'},
+                                          {"cache", required_argument, NULL, 'C'},
+                                          {NULL, 0, NULL, 0}};
+
+    while ((c = getopt_long(argc, argv, "her:a:c:f:s:pn:M:S:lDt:T:xj:", longOptions, NULL)) != -1)
         switch (c) {
+        case 'u':
+            uniqueFlag = 1;
+            break;
+        case 'm':
+            sweep = SWEEP_M;
+            break;
+        case 'd':
+            sweep = SWEEP_S;
+            break;
+        case 'w':
+            warmFlag = 1;
+            break;
+        case 'i':
+            ilsFlag = 1;
+            break;
+        case 'P':
+            temperingFlag = 1;
+            break;
+        case 'F':
+            portfolioFlag = 1;
+            break;
+        case 'G':
+            statsFlag = 1;
+            break;
+        case 'C':
+            cacheFile = optarg;
+            break;
         case 'h':
             helpFlag = 1;
             break;
@@ -123,6 +540,12 @@ int main(int argc, char** argv) {
         case 'D':
             diffFlag = 1;
             break;
+        case 'x':
+            exactFlag = 1;
+            break;
+        case 'j':
+            threads = atoi(optarg);
+            break;
         case 't':
             timeout = atoi(optarg);
             break;
@@ -146,8 +569,11 @@ int main(int argc, char** argv) {
         case '?':
             if (optopt == 'f' || optopt == 'n' || optopt == 'M' ||
                 optopt == 'S' || optopt == 'c' || optopt == 's' ||
-                optopt == 't' || optopt == 'r')
+                optopt == 't' || optopt == 'r' || optopt == 'j')
                 fprintf(stderr, "Option -%c requires an argument.  Use ./solveuri -h to see more detailed instructions.\n", optopt);
+            else if (optopt == 0)
+                // Unknown long option, getopt_long already named it
+                fprintf(stderr, "Use ./solveuri -h to see more detailed instructions.\n");
             else if (isprint(optopt))
                 fprintf(stderr, "Unknown option `-%c'. Use ./solveuri -h to see more detailed instructions.\n", optopt);
             else fprintf(stderr, "Unknown option character `\\x%x'.  Use ./solveuri -h to see more detailed instructions.\n", optopt);
@@ -170,6 +596,42 @@ int main(int argc, char** argv) {
         return 1;
     }
 
+    if (exactFlag && (diffFlag || step == -1 || rectangleFlag || taboo_size)) {
+        fprintf(stderr, "Incompatible parameters, the exact solver needs a known step,"
+                        " moves every label, and does not solve rectangles or different weights\n"
+                        "Use ./solveuri -h to see more detailed instructions\n");
+        return 1;
+    }
+
+    if (exactFlag + ilsFlag + temperingFlag + portfolioFlag > 1) {
+        fprintf(stderr, "Incompatible parameters, you can only use one search among"
+                        " the exact solver, --ils, --tempering and --portfolio\n"
+                        "Use ./solveuri -h to see more detailed instructions\n");
+        return 1;
+    }
+
+    if (sweep && (diffFlag || exactFlag || rectangleFlag || stepFlag ||
+                  (sweep == SWEEP_M && magicFlag))) {
+        fprintf(stderr, "Incompatible parameters, a sweep chooses the constant or the step itself,"
+                        " and does not solve rectangles, different weights or with the exact solver\n"
+                        "Use ./solveuri -h to see more detailed instructions\n");
+        return 1;
+    }
+
+    if (warmFlag && (relabelFlag || sweep || exactFlag || !filename)) {
+        fprintf(stderr, "Incompatible parameters, a warm start needs a labelled file to restart from,"
+                        " and cannot relabel it, sweep or use the exact solver\n"
+                        "Use ./solveuri -h to see more detailed instructions\n");
+        return 1;
+    }
+
+    if (cacheFile && (sweep || uniqueFlag || rectangleFlag || statsFlag)) {
+        fprintf(stderr, "Incompatible parameters, the cache keeps one result per graph,"
+                        " it cannot be used to sweep, find unique solutions, solve rectangles or print statistics\n"
+                        "Use ./solveuri -h to see more detailed instructions\n");
+        return 1;
+    }
+
     if (rectangleFlag && editorFlag) {
         fprintf(stderr, "Incompatible parameters, you cannot edit a rectangle in the editor\n"
                         "Use ./solveuri -h to see more detailed instructions\n");
@@ -181,6 +643,15 @@ int main(int argc, char** argv) {
         return 0;
     }
 
+    if (statsFlag) {
+        if (!fileFlag || editorFlag) {
+            fprintf(stderr, "Invalid parameters, the statistics need a file of graphs generated by geng\n"
+                            "Use ./solveuri -h to see more detailed instructions\n");
+            return 1;
+        }
+        return printStatistics(filename, threads) < 0;
+    }
+
     // Rectangles logic is different
     if (rectangleFlag) {
         if (l <= 0 || L <= 0) {
@@ -195,6 +666,9 @@ int main(int argc, char** argv) {
 
             int const_l;
             int const_L;
+            if (cpt == 1 && step_l == 0 && step_L == 0 && constructMagicRectangle(r)) {
+                printf("Starting %s from a known construction\n", r->g->name);
+            }
             solvedRect = solveAntiMagicRect(r, step_l, step_L, &const_l, &const_L);
 
             if (!solvedRect) { continue; }
@@ -209,6 +683,7 @@ int main(int argc, char** argv) {
             freeRectangle(r);
             r = createRectangle("Rectangle", l, L);
         }
+        freeRectangle(r);
         return 0;
     }
 
@@ -219,124 +694,52 @@ int main(int argc, char** argv) {
         sscanf(filename, "%[^.].%s", name, ext);
     }
 
-    // We will solve immediatly solve, no editor required
+    Options o = {nb, relabelFlag, pflag, directory, diffFlag,
+                 magic_constant, step, taboo, taboo_size, exactFlag, threads, uniqueFlag, NULL, sweep, warmFlag, ilsFlag, temperingFlag, portfolioFlag, NULL};
+
+    if (warmFlag && strcmp(ext, "dot") != 0) {
+        fprintf(stderr, "Invalid parameters, a warm start needs a dot file\n"
+                        "Use ./solveuri -h to see more detailed instructions\n");
+        return 1;
+    }
+
+    if (cacheFile && !(o.cache = openCache(cacheFile))) { return 1; }
+
+    // We solve immediately, no editor required
     if (filename && !editorFlag) {
-        CellGraph* gl;
-        Graph* g;
-        Graph* init;
-        Solver* s;
         if (strcmp(ext, "dot") != 0) {
-            CellGraph* gl = parseAllGraphs(filename)->head;
+            GraphList* list = parseAllGraphs(filename);
+            if (!list) { return 1; }
+            CellGraph* gl = list->head;
+            Solver* s = NULL;
+            int nbGraphs = 0;
+            int nbRejected = 0;
 
             while (gl) {
-
-                for (int cpt = 1; cpt < nb + 1; cpt++) {
-                    g = cloneGraph(gl->g);
-
-                    relabelGraph(g);
-
-                    if (diffFlag) {
-                        s = attemptSolve(6, g, 0, 0, 0, 0, taboo, taboo_size);
-                    } else if (step == 0) {
-                        if (magic_constant == 0) {
-                            s = attemptSolve(2, g, 0, 0, 0, 0, taboo,
-                                             taboo_size);
-                        } else {
-                            s = attemptSolve(0, g, magic_constant, 0, 0, 0,
-                                             taboo, taboo_size);
-                        }
-                    } else if (step == -1) {
-                        if (magic_constant == 0) {
-                            s = attemptSolve(4, g, 0, 0, 0, 0, taboo,
-                                             taboo_size);
-                            ;
-                        } else {
-                            s = attemptSolve(5, g, magic_constant, 0, 0, 0,
-                                             taboo, taboo_size);
-                        }
-                    } else {
-                        if (magic_constant == 0) {
-                            s = attemptSolve(3, g, magic_constant, 0, step, 0,
-                                             taboo, taboo_size);
-                            ;
-                        } else {
-                            s = attemptSolve(0, g, magic_constant, 0, step, 0,
-                                             taboo, taboo_size);
-                        }
-                    }
-                    if (!s) { continue; }
-                    g = s->g;
-                    if (pflag) { printGraph(g); }
-                    if (strcmp(directory, "")) {
-                        if (diffFlag) {
-                            sprintf(buff, "%s/Graph_%s_n%d.dot", directory,
-                                    init->name, cpt);
-                        } else if (step == 0) {
-                            sprintf(buff, "%s/Graph_%s_%d-VMT_n%d.dot",
-                                    directory, gl->g->name, getMagicConst(g),
-                                    cpt);
-                        } else {
-                            getAntimagicConst(s, &a, &d);
-                            sprintf(buff, "%s/Graph_%s_(%d,%d)-VAT_n%d.dot",
-                                    directory, gl->g->name, a, d,
-                                    cpt);
-                        }
-                        generateDotFile(buff, g, 0);
-                    }
+                // The same solver is reused for all the graphs of the file
+                if (!s) {
+                    s = createSolver(gl->g);
+                } else {
+                    bindSolver(s, gl->g);
                 }
+                // The parsed labels are sequential, they are always relabelled
+                nbRejected += !solveAttempts(s, gl->g->name, 1, &o);
+                nbGraphs++;
                 gl = gl->nxt;
             }
-        } else {
-            init = getFromDotFile(filename);
-            for (int cpt = 1; cpt < nb + 1; cpt++) {
-                g = cloneGraph(init);
-                if (relabelFlag) { relabelGraph(g); }
-                if (diffFlag) {
-                    s = attemptSolve(6, g, 0, 0, 0, 0, taboo, taboo_size);
-                } else if (step == 0) {
-                    if (magic_constant == 0) {
-                        s = attemptSolve(2, g, 0, 0, 0, 0, taboo, taboo_size);
-                    } else {
-                        s = attemptSolve(0, g, magic_constant, 0, 0, 0, taboo,
-                                         taboo_size);
-                    }
-                } else if (step == -1) {
-                    if (magic_constant == 0) {
-                        s = attemptSolve(4, g, 0, 0, 0, 0, taboo, taboo_size);
-
-                    } else {
-                        s = attemptSolve(5, g, magic_constant, 0, 0, 0, taboo,
-                                         taboo_size);
-                    }
-                } else {
-                    if (magic_constant == 0) {
-                        s = attemptSolve(3, g, magic_constant, 0, step, 0, taboo,
-                                         taboo_size);
-                        ;
-                    } else {
-                        s = attemptSolve(0, g, magic_constant, 0, step, 0,
-                                         taboo, taboo_size);
-                    }
-                }
-                if (!s) { continue; }
-                g = s->g;
-                if (pflag) { printGraph(g); }
-                if (strcmp(directory, "")) {
-                    if (diffFlag) {
-                        sprintf(buff, "%s/Graph_%s_n%d.dot", directory,
-                                init->name, cpt);
-                    } else if (step == 0) {
-                        sprintf(buff, "%s/Graph_%s_%d-VMT_n%d.dot", directory,
-                                init->name, getMagicConst(g), cpt);
-                    } else {
-                        getAntimagicConst(s, &a, &d);
-                        sprintf(buff, "%s/Graph_%s_(%d,%d)-VAT_n%d.dot",
-                                directory, init->name, a, d, cpt);
-                    }
-                    generateDotFile(buff, g, 0);
-                }
+            if (nbRejected) {
+                printf("%d of the %d graphs were rejected before any attempt\n", nbRejected,
+                       nbGraphs);
             }
+            if (s) { freeSolver(s, 0); }
+            freeList(list);
+        } else {
+            Graph* init = getFromDotFile(filename);
+            Solver* s = createSolver(init);
+            solveAttempts(s, init->name, relabelFlag, &o);
+            freeSolver(s, 1);
         }
+        if (o.cache) { closeCache(o.cache); }
         return 0;
     }
 
@@ -377,55 +780,25 @@ int main(int argc, char** argv) {
         return 1;
     }
 
-    Graph* g;
-    Solver* s;
-    for (int cpt = 1; cpt < nb + 1; cpt++) {
-        g = cloneGraph(toSolve);
-        if (relabelFlag) { relabelGraph(g); }
-        if (diffFlag) {
-            s = attemptSolve(6, g, 0, 0, 0, 0, taboo, taboo_size);
-        } else if (step == 0) {
-            if (magic_constant == 0) {
-                s = attemptSolve(2, g, 0, 0, 0, 0, taboo, taboo_size);
-            } else {
-                s = attemptSolve(0, g, magic_constant, 0, 0, 0, taboo,
-                                 taboo_size);
-            }
-        } else if (step == -1) {
-            if (magic_constant == 0) {
-                s = attemptSolve(4, g, 0, 0, 0, 0, taboo, taboo_size);
-                ;
-            } else {
-                s = attemptSolve(5, g, magic_constant, 0, 0, 0, taboo,
-                                 taboo_size);
-            }
-        } else {
-            if (magic_constant == 0) {
-                s = attemptSolve(3, g, magic_constant, 0, step, 0, taboo,
-                                 taboo_size);
-                ;
-            } else {
-                s = attemptSolve(0, g, magic_constant, 0, step, 0, taboo,
-                                 taboo_size);
-            }
-        }
-        if (!s) { continue; }
-        g = s->g;
-        if (pflag) { printGraph(g); }
-        if (directory) {
-            if (diffFlag) {
-                sprintf(buff, "%s/Graph_%s_n%d.dot", directory,
-                        toSolve->name, cpt);
-            } else if (step == 0) {
-                sprintf(buff, "%s/Graph_%s_%d-VMT_n%d.dot", directory,
-                        toSolve->name, getMagicConst(g), cpt);
-            } else {
-                getAntimagicConst(s, &a, &d);
-                sprintf(buff, "%s/Graph_%s_(%d,%d)-VAT_n%d.dot", directory,
-                        toSolve->name, a, d, cpt);
-            }
-            generateDotFile(buff, g, 0);
+    // Known constructions give the first attempt a solution at once
+    Graph* known = NULL;
+    if (completeFlag && complete_size % 2 == 1) { known = oddCompleteVMT(complete_size); }
+    if (antiprismFlag && antiprism_size % 2 == 1) {
+        known = oddAntiprismVMT("Antiprism", antiprism_size);
+    }
+    if (known && !editorFlag && step == 0 && !diffFlag && !taboo && !sweep) {
+        o.seed = malloc((known->nbv + known->nbe) * sizeof(int));
+        if (!seedFromConstruction(known, magic_constant, o.seed)) {
+            free(o.seed);
+            o.seed = NULL;
         }
     }
+    if (known) { freeGraph(known); }
+
+    Solver* s = createSolver(toSolve);
+    solveAttempts(s, toSolve->name, relabelFlag, &o);
+    freeSolver(s, 1);
+    free(o.seed);
+    if (o.cache) { closeCache(o.cache); }
     return 0;
 }
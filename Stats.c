@@ -0,0 +1,141 @@
+#include "Stats.h"
+#include "GraphParser.h"
+#include "Solver.h"
+#include "Utils.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * The graphs of a batch, as text, and their rows once studied
+ */
+typedef struct _statsBatch {
+    char* texts[STATS_BATCH];
+    int textCapacities[STATS_BATCH];
+    char* rows[STATS_BATCH];
+    int rowCapacities[STATS_BATCH];
+    int size;
+    // The next graph to study, the threads take them in turn
+    int next;
+} StatsBatch;
+
+int degeneracy(Graph* g, int* order) {
+    int* position = malloc((g->nbv + 1) * sizeof(int));
+    int* later = calloc(g->nbv + 1, sizeof(int));
+    int* ends = malloc((2 * g->nbe + 1) * sizeof(int));
+    for (int i = 0; i < g->nbv; i++) {
+        position[order[i]] = i;
+    }
+    getEdgesEndpoints(g, ends);
+    for (int i = 0; i < g->nbe; i++) {
+        int u = ends[2 * i];
+        int v = ends[2 * i + 1];
+        if (u == v) { continue; }
+        // The edge is counted for the endpoint removed first
+        later[position[u] < position[v] ? u : v]++;
+    }
+    int res = 0;
+    for (int i = 0; i < g->nbv; i++) {
+        if (later[i] > res) { res = later[i]; }
+    }
+    free(position);
+    free(later);
+    free(ends);
+    return res;
+}
+
+/**
+ * Writes the row of statistics of a graph
+ * @param row The buffer of the row, reallocated if needed
+ * @param capacity The size of the buffer, updated when it grows
+ */
+void writeStatistics(Graph* g, char** row, int* capacity) {
+    // At most 11 characters per degree, and the other columns
+    int needed = 12 * g->nbv + 2 * BUFFER_SIZE;
+    if (needed > *capacity) {
+        *capacity = needed;
+        *row = realloc(*row, needed);
+    }
+    int* degrees = degreesTab(g);
+    qsort(degrees, g->nbv, sizeof(int), cmp_inv);
+    int* order = degeneratedOrder(g);
+
+    int length = sprintf(*row, "%s\t%d\t%d\t", g->name, g->nbv, g->nbe);
+    for (int i = 0; i < g->nbv; i++) {
+        length += sprintf(*row + length, i ? ",%d" : "%d", degrees[i]);
+    }
+    sprintf(*row + length, "\t%d\t%d\t%d\t%d\t%d\n", countTriangle(g), degeneracy(g, order),
+            isConnected(g), getMinMagicConst(g), getMaxMagicConst(g));
+    free(degrees);
+    free(order);
+}
+
+void* statsWorker(void* arg) {
+    StatsBatch* b = (StatsBatch*)arg;
+    int i;
+    while ((i = __atomic_fetch_add(&b->next, 1, __ATOMIC_RELAXED)) < b->size) {
+        Graph* g = parseGraphText(b->texts[i]);
+        if (!g || !g->nbv) {
+            b->rows[i][0] = '\0';
+        } else {
+            writeStatistics(g, b->rows + i, b->rowCapacities + i);
+        }
+        if (g) { freeGraph(g); }
+    }
+    return NULL;
+}
+
+long printStatistics(char* filename, int nbThreads) {
+    FILE* f = fopen(filename, "r");
+    if (!f) {
+        fprintf(stderr, "Could not open %s when trying to parse graphs\n", filename);
+        return -1;
+    }
+    if (nbThreads < 1) { nbThreads = 1; }
+    clock_t start = clock();
+    time_t wallStart = time(NULL);
+
+    StatsBatch* b = malloc(sizeof(StatsBatch));
+    for (int i = 0; i < STATS_BATCH; i++) {
+        b->texts[i] = NULL;
+        b->textCapacities[i] = 0;
+        b->rowCapacities[i] = BUFFER_SIZE;
+        b->rows[i] = malloc(BUFFER_SIZE);
+    }
+    pthread_t threads[nbThreads];
+    long res = 0;
+
+    printf("graph\tn\tm\tdegrees\ttriangles\tdegeneracy\tconnected\tminK\tmaxK\n");
+    do {
+        b->size = 0;
+        b->next = 0;
+        while (b->size < STATS_BATCH &&
+               readGraphText(f, b->texts + b->size, b->textCapacities + b->size)) {
+            b->size++;
+        }
+        for (int i = 0; i < nbThreads; i++) {
+            pthread_create(&threads[i], NULL, statsWorker, b);
+        }
+        for (int i = 0; i < nbThreads; i++) {
+            pthread_join(threads[i], NULL);
+        }
+        for (int i = 0; i < b->size; i++) {
+            fputs(b->rows[i], stdout);
+        }
+        res += b->size;
+    } while (b->size == STATS_BATCH);
+
+    for (int i = 0; i < STATS_BATCH; i++) {
+        free(b->texts[i]);
+        free(b->rows[i]);
+    }
+    free(b);
+    fclose(f);
+    fflush(stdout);
+    fprintf(stderr, "Statistics of %ld graphs in %lds (%.2fs of processor time)\n", res,
+            (long)(time(NULL) - wallStart), (double)(clock() - start) / CLOCKS_PER_SEC);
+    return res;
+}
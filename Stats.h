@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Graph.h"
+
+/**
+ * The number of graphs read before they are dispatched to the threads
+ */
+#define STATS_BATCH 4096
+
+/**
+ * Computes the degeneracy of a graph from its degeneracy order
+ * @param g The graph
+ * @param order The order of the vertices, see degeneratedOrder
+ * @return The largest number of edges from a vertex to the vertices after it
+ */
+int degeneracy(Graph* g, int* order);
+
+/**
+ * Prints a table of statistics of every graph of a file, without solving them:
+ * the name, the order, the size, the degrees in decreasing order, the number of
+ * triangles, the degeneracy, 1 if the graph is connected, and the smallest and
+ * largest possible magic constants of a VMT.
+ *
+ * The file is read as a stream, STATS_BATCH graphs at a time. The graphs of a
+ * batch are parsed and studied on several threads, and their rows are printed
+ * in the order of the file.
+ *
+ * @param filename The file of graphs, see parseAllGraphs
+ * @param nbThreads The number of threads to use
+ * @return The number of graphs, -1 if the file could not be opened
+ */
+long printStatistics(char* filename, int nbThreads);
@@ -0,0 +1,488 @@
+#include "Symmetry.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * The graph as an adjacency matrix and lists, with the buffers
+ * used to refine the partitions of its vertices
+ */
+typedef struct _refiner {
+    int n;
+    char* adj;
+    int* offsets;
+    int* neighbours;
+    int* counts;
+    int* index;
+    int* buffer;
+    int* colors;
+    int nc;
+} Refiner;
+
+Refiner* createRefiner(Graph* g) {
+    int n = g->nbv;
+    Refiner* r = malloc(sizeof(Refiner));
+    r->n = n;
+    r->adj = calloc(n * n, sizeof(char));
+    r->offsets = calloc(n + 1, sizeof(int));
+    r->neighbours = malloc(2 * g->nbe * sizeof(int));
+    r->counts = malloc(n * n * sizeof(int));
+    r->index = malloc(n * sizeof(int));
+    r->buffer = malloc(n * sizeof(int));
+
+    int* ends = malloc(2 * g->nbe * sizeof(int));
+    getEdgesEndpoints(g, ends);
+    for (int i = 0; i < 2 * g->nbe; i++) {
+        r->offsets[ends[i] + 1]++;
+    }
+    for (int v = 0; v < n; v++) {
+        r->offsets[v + 1] += r->offsets[v];
+    }
+    int* fill = malloc(n * sizeof(int));
+    memcpy(fill, r->offsets, n * sizeof(int));
+    for (int i = 0; i < g->nbe; i++) {
+        int u = ends[2 * i];
+        int v = ends[2 * i + 1];
+        r->neighbours[fill[u]++] = v;
+        r->neighbours[fill[v]++] = u;
+        r->adj[u * n + v] = 1;
+        r->adj[v * n + u] = 1;
+    }
+    free(fill);
+    free(ends);
+    return r;
+}
+
+void freeRefiner(Refiner* r) {
+    free(r->adj);
+    free(r->offsets);
+    free(r->neighbours);
+    free(r->counts);
+    free(r->index);
+    free(r->buffer);
+    free(r);
+}
+
+/**
+ * Compares two vertices by their color, then by their number of neighbours of each color
+ */
+int compareVertices(Refiner* r, int u, int v) {
+    if (r->colors[u] != r->colors[v]) { return r->colors[u] - r->colors[v]; }
+    return memcmp(r->counts + u * r->nc, r->counts + v * r->nc, r->nc * sizeof(int));
+}
+
+void sortVertices(Refiner* r, int* tab, int* tmp, int size) {
+    if (size < 2) { return; }
+    int half = size / 2;
+    sortVertices(r, tab, tmp, half);
+    sortVertices(r, tab + half, tmp, size - half);
+    int i = 0;
+    int j = half;
+    int k = 0;
+    while (i < half && j < size) {
+        if (compareVertices(r, tab[j], tab[i]) < 0) {
+            tmp[k++] = tab[j++];
+        } else {
+            tmp[k++] = tab[i++];
+        }
+    }
+    while (i < half) { tmp[k++] = tab[i++]; }
+    while (j < size) { tmp[k++] = tab[j++]; }
+    memcpy(tab, tmp, size * sizeof(int));
+}
+
+/**
+ * Splits the colors until two vertices of the same color have the same number
+ * of neighbours of each color. The new colors only depend on the structure of
+ * the partition, so that the partitions of isomorphic colorings stay isomorphic
+ * @param r The refiner of the graph
+ * @param colors The color of each vertex, between 0 and nc-1
+ * @param nc The number of colors
+ * @return The number of colors of the refined partition
+ */
+int refinePartition(Refiner* r, int* colors, int nc) {
+    int n = r->n;
+    r->colors = colors;
+    while (1) {
+        r->nc = nc;
+        memset(r->counts, 0, n * nc * sizeof(int));
+        for (int v = 0; v < n; v++) {
+            r->index[v] = v;
+            for (int i = r->offsets[v]; i < r->offsets[v + 1]; i++) {
+                r->counts[v * nc + colors[r->neighbours[i]]]++;
+            }
+        }
+        int* sorted = malloc(n * sizeof(int));
+        sortVertices(r, r->index, sorted, n);
+
+        int newNc = 0;
+        for (int i = 0; i < n; i++) {
+            if (i > 0 && compareVertices(r, r->index[i - 1], r->index[i]) != 0) { newNc++; }
+            sorted[r->index[i]] = newNc;
+        }
+        newNc = n ? newNc + 1 : 0;
+        memcpy(colors, sorted, n * sizeof(int));
+        free(sorted);
+        if (newNc == nc) { return nc; }
+        nc = newNc;
+    }
+}
+
+/**
+ * @return 1 if the colors have the same sizes in both partitions, 0 if not
+ */
+int sameCellSizes(Refiner* r, int* a, int* b, int nc) {
+    int* sizes = calloc(nc, sizeof(int));
+    for (int v = 0; v < r->n; v++) {
+        sizes[a[v]]++;
+        sizes[b[v]]--;
+    }
+    int res = 1;
+    for (int c = 0; c < nc; c++) {
+        if (sizes[c]) { res = 0; }
+    }
+    free(sizes);
+    return res;
+}
+
+/**
+ * Gives the vertex v a color of its own, then refines the partition
+ * @return The number of colors of the refined partition
+ */
+int individualize(Refiner* r, int* colors, int nc, int v) {
+    colors[v] = nc;
+    return refinePartition(r, colors, nc + 1);
+}
+
+/**
+ * Searches an automorphism mapping every vertex of a color in a to a vertex
+ * of the same color in b
+ * @param perm The table of size n where the automorphism is stored
+ * @return 1 if an automorphism was found, 0 if not
+ */
+int findAutomorphism(Refiner* r, int* a, int* b, int nc, int* perm) {
+    int n = r->n;
+    if (nc == n) {
+        int* byColor = malloc(n * sizeof(int));
+        for (int u = 0; u < n; u++) {
+            byColor[b[u]] = u;
+        }
+        for (int v = 0; v < n; v++) {
+            perm[v] = byColor[a[v]];
+        }
+        free(byColor);
+        for (int v = 0; v < n; v++) {
+            for (int i = r->offsets[v]; i < r->offsets[v + 1]; i++) {
+                if (!r->adj[perm[v] * n + perm[r->neighbours[i]]]) { return 0; }
+            }
+        }
+        return 1;
+    }
+
+    // The first color with several vertices is split
+    int* sizes = calloc(nc, sizeof(int));
+    for (int v = 0; v < n; v++) {
+        sizes[a[v]]++;
+    }
+    int cell = 0;
+    while (sizes[cell] == 1) { cell++; }
+    free(sizes);
+    int v = 0;
+    while (a[v] != cell) { v++; }
+
+    int* a2 = malloc(n * sizeof(int));
+    int* b2 = malloc(n * sizeof(int));
+    memcpy(a2, a, n * sizeof(int));
+    int ncA = individualize(r, a2, nc, v);
+    int found = 0;
+    for (int u = 0; u < n && !found; u++) {
+        if (b[u] != cell) { continue; }
+        memcpy(b2, b, n * sizeof(int));
+        int ncB = individualize(r, b2, nc, u);
+        if (ncA != ncB || !sameCellSizes(r, a2, b2, ncA)) { continue; }
+        found = findAutomorphism(r, a2, b2, ncA, perm);
+    }
+    free(a2);
+    free(b2);
+    return found;
+}
+
+int findOrbit(int* parent, int v) {
+    while (parent[v] != v) {
+        parent[v] = parent[parent[v]];
+        v = parent[v];
+    }
+    return v;
+}
+
+Symmetry* computeSymmetry(Graph* g, int* order) {
+    int n = g->nbv;
+    Refiner* r = createRefiner(g);
+    Symmetry* s = malloc(sizeof(Symmetry));
+    s->nbv = n;
+    s->baseSize = 0;
+    s->base = malloc(n * sizeof(int));
+    s->nbGenerators = 0;
+
+    // The partition before each base point is individualized
+    int* levelColors = malloc(n * n * sizeof(int));
+    int* levelNc = malloc(n * sizeof(int));
+    int* colors = calloc(n, sizeof(int));
+    int* sizes = malloc(n * sizeof(int));
+    int nc = refinePartition(r, colors, n ? 1 : 0);
+    while (nc < n) {
+        memcpy(levelColors + s->baseSize * n, colors, n * sizeof(int));
+        levelNc[s->baseSize] = nc;
+        memset(sizes, 0, n * sizeof(int));
+        for (int v = 0; v < n; v++) {
+            sizes[colors[v]]++;
+        }
+        int b = -1;
+        for (int i = 0; i < n && b == -1; i++) {
+            int v = order ? order[i] : i;
+            if (sizes[colors[v]] > 1) { b = v; }
+        }
+        s->base[s->baseSize++] = b;
+        nc = individualize(r, colors, nc, b);
+    }
+
+    // The orbits of the stabilizers grow from the last base point to the first
+    int* parent = malloc(n * sizeof(int));
+    for (int v = 0; v < n; v++) {
+        parent[v] = v;
+    }
+    int* orbitOf = malloc(n * n * sizeof(int));
+    int* orbitSize = calloc(n, sizeof(int));
+    int* a = malloc(n * sizeof(int));
+    int* perm = malloc(n * sizeof(int));
+    for (int i = s->baseSize - 1; i >= 0; i--) {
+        int b = s->base[i];
+        int* level = levelColors + i * n;
+        memcpy(a, level, n * sizeof(int));
+        int ncA = individualize(r, a, levelNc[i], b);
+        for (int w = 0; w < n; w++) {
+            if (level[w] != level[b] || findOrbit(parent, w) == findOrbit(parent, b)) { continue; }
+            memcpy(colors, level, n * sizeof(int));
+            int ncB = individualize(r, colors, levelNc[i], w);
+            if (ncA != ncB || !sameCellSizes(r, a, colors, ncA)) { continue; }
+            if (!findAutomorphism(r, a, colors, ncA, perm)) { continue; }
+            s->nbGenerators++;
+            for (int v = 0; v < n; v++) {
+                parent[findOrbit(parent, v)] = findOrbit(parent, perm[v]);
+            }
+        }
+        for (int w = 0; w < n; w++) {
+            if (findOrbit(parent, w) == findOrbit(parent, b)) {
+                orbitOf[i * n + orbitSize[i]++] = w;
+            }
+        }
+    }
+
+    s->orbitStart = malloc((s->baseSize + 1) * sizeof(int));
+    s->orbitStart[0] = 0;
+    for (int i = 0; i < s->baseSize; i++) {
+        s->orbitStart[i + 1] = s->orbitStart[i] + orbitSize[i];
+    }
+    s->orbits = malloc((s->orbitStart[s->baseSize] + 1) * sizeof(int));
+    for (int i = 0; i < s->baseSize; i++) {
+        memcpy(s->orbits + s->orbitStart[i], orbitOf + i * n, orbitSize[i] * sizeof(int));
+    }
+
+    free(levelColors);
+    free(levelNc);
+    free(colors);
+    free(sizes);
+    free(parent);
+    free(orbitOf);
+    free(orbitSize);
+    free(a);
+    free(perm);
+    freeRefiner(r);
+    return s;
+}
+
+void freeSymmetry(Symmetry* s) {
+    free(s->base);
+    free(s->orbitStart);
+    free(s->orbits);
+    free(s);
+}
+
+double groupOrder(Symmetry* s) {
+    double res = 1;
+    for (int i = 0; i < s->baseSize; i++) {
+        res *= s->orbitStart[i + 1] - s->orbitStart[i];
+    }
+    return res;
+}
+
+/**
+ * The search of the canonical form, and the best leaf found so far
+ */
+typedef struct _canonSearch {
+    Refiner* r;
+    int nbe;
+    int* ends;
+    int* edgeColors;
+    // The colored edges (u, v, color) of the graph, sorted, to check the automorphisms
+    int* triples;
+    int* mapped;
+    int* form;
+    int* leaf;
+    int* position;
+    int found;
+} CanonSearch;
+
+int cmpEdgeTriple(const void* a, const void* b) {
+    const int* x = (const int*)a;
+    const int* y = (const int*)b;
+    for (int i = 0; i < 3; i++) {
+        if (x[i] != y[i]) { return x[i] < y[i] ? -1 : 1; }
+    }
+    return 0;
+}
+
+/**
+ * Fills the triples (u, v, color) of the edges of the graph once its vertices
+ * are renamed by perm, with u <= v, sorted
+ */
+void edgeTriples(CanonSearch* c, int* perm, int* triples) {
+    for (int i = 0; i < c->nbe; i++) {
+        int u = perm[c->ends[2 * i]];
+        int v = perm[c->ends[2 * i + 1]];
+        triples[3 * i] = u < v ? u : v;
+        triples[3 * i + 1] = u < v ? v : u;
+        triples[3 * i + 2] = c->edgeColors ? c->edgeColors[i] : 0;
+    }
+    qsort(triples, c->nbe, 3 * sizeof(int), cmpEdgeTriple);
+}
+
+/**
+ * findAutomorphism only checks the adjacency, the multiplicities and the
+ * colors of the edges are checked here
+ * @return 1 if perm keeps the colored edges, 0 if not
+ */
+int keepsEdges(CanonSearch* c, int* perm) {
+    edgeTriples(c, perm, c->mapped);
+    return !memcmp(c->mapped, c->triples, 3 * c->nbe * sizeof(int));
+}
+
+/**
+ * Explores the children of a node of the search tree. A child that is the
+ * image of an explored one by an automorphism keeping the partition of the
+ * node has the same leaves, so it is skipped
+ */
+void searchCanonical(CanonSearch* c, int* colors, int nc) {
+    Refiner* r = c->r;
+    int n = r->n;
+    if (nc == n) {
+        for (int v = 0; v < n; v++) {
+            c->leaf[colors[v]] = c->form[n + 3 * c->nbe + v];
+        }
+        edgeTriples(c, colors, c->leaf + n);
+        int size = n + 3 * c->nbe;
+        if (!c->found || memcmp(c->leaf, c->form, size * sizeof(int)) < 0) {
+            memcpy(c->form, c->leaf, size * sizeof(int));
+            memcpy(c->position, colors, n * sizeof(int));
+            c->found = 1;
+        }
+        return;
+    }
+
+    int* sizes = calloc(nc, sizeof(int));
+    for (int v = 0; v < n; v++) {
+        sizes[colors[v]]++;
+    }
+    int cell = 0;
+    while (sizes[cell] == 1) { cell++; }
+    free(sizes);
+
+    // The explored children, and the one being tried after them
+    int capacity = 4;
+    int* children = malloc(capacity * n * sizeof(int));
+    int* childNc = malloc(capacity * sizeof(int));
+    int* perm = malloc(n * sizeof(int));
+    int nbChildren = 0;
+    for (int w = 0; w < n; w++) {
+        if (colors[w] != cell) { continue; }
+        if (nbChildren + 1 == capacity) {
+            capacity *= 2;
+            children = realloc(children, capacity * n * sizeof(int));
+            childNc = realloc(childNc, capacity * sizeof(int));
+        }
+        int* child = children + nbChildren * n;
+        memcpy(child, colors, n * sizeof(int));
+        int ncW = individualize(r, child, nc, w);
+        int equivalent = 0;
+        for (int i = 0; i < nbChildren && !equivalent; i++) {
+            int* explored = children + i * n;
+            if (childNc[i] != ncW || !sameCellSizes(r, explored, child, ncW)) { continue; }
+            equivalent = findAutomorphism(r, explored, child, ncW, perm) && keepsEdges(c, perm);
+        }
+        if (equivalent) { continue; }
+        childNc[nbChildren++] = ncW;
+        searchCanonical(c, child, ncW);
+    }
+    free(children);
+    free(childNc);
+    free(perm);
+}
+
+void canonicalGraph(Graph* g, int* vertexColors, int* edgeColors, int* position, int* form) {
+    int n = g->nbv;
+    int m = g->nbe;
+    CanonSearch c;
+    c.r = createRefiner(g);
+    c.nbe = m;
+    c.ends = malloc((2 * m + 1) * sizeof(int));
+    getEdgesEndpoints(g, c.ends);
+    c.edgeColors = edgeColors;
+    c.triples = malloc((3 * m + 1) * sizeof(int));
+    c.mapped = malloc((3 * m + 1) * sizeof(int));
+    int* identity = malloc((n + 1) * sizeof(int));
+    for (int v = 0; v < n; v++) {
+        identity[v] = v;
+    }
+    edgeTriples(&c, identity, c.triples);
+    free(identity);
+    // The colors of the vertices are kept after the form, the leaves read them there
+    c.form = malloc((2 * n + 3 * m + 1) * sizeof(int));
+    c.leaf = malloc((n + 3 * m + 1) * sizeof(int));
+    c.position = position;
+    c.found = 0;
+
+    // The first partition splits the vertices by color, then by number of colored
+    // edges. The keys are sorted with the vertex last, the colors are their ranks
+    int* keys = malloc((3 * n + 1) * sizeof(int));
+    for (int v = 0; v < n; v++) {
+        keys[3 * v] = vertexColors ? vertexColors[v] : 0;
+        keys[3 * v + 1] = 0;
+        keys[3 * v + 2] = v;
+        c.form[n + 3 * m + v] = keys[3 * v];
+    }
+    for (int i = 0; i < 2 * m && edgeColors; i++) {
+        keys[3 * c.ends[i] + 1] += edgeColors[i / 2] != 0;
+    }
+    qsort(keys, n, 3 * sizeof(int), cmpEdgeTriple);
+    int* colors = malloc((n + 1) * sizeof(int));
+    int nc = 0;
+    for (int i = 0; i < n; i++) {
+        if (i > 0 && (keys[3 * i] != keys[3 * i - 3] || keys[3 * i + 1] != keys[3 * i - 2])) {
+            nc++;
+        }
+        colors[keys[3 * i + 2]] = nc;
+    }
+    nc = n ? nc + 1 : 0;
+    free(keys);
+    nc = refinePartition(c.r, colors, nc);
+    searchCanonical(&c, colors, nc);
+
+    memcpy(form, c.form, (n + 3 * m) * sizeof(int));
+    free(colors);
+    free(c.ends);
+    free(c.triples);
+    free(c.mapped);
+    free(c.form);
+    free(c.leaf);
+    freeRefiner(c.r);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Graph.h"
+
+/**
+ * The automorphism group of a graph, described by a stabilizer chain.
+ * The base points b0, b1, ... are vertices such that the only automorphism
+ * fixing all of them is the identity. The orbit i is the orbit of b_i under
+ * the automorphisms fixing b0, ..., b_(i-1).
+ *
+ * Use the computeSymmetry function to properly create one
+ */
+typedef struct _symmetry {
+    int nbv;
+    int baseSize;
+    int* base;
+    // The orbit i is orbits[orbitStart[i]] to orbits[orbitStart[i+1]-1]
+    int* orbitStart;
+    int* orbits;
+    int nbGenerators;
+} Symmetry;
+
+/**
+ * Computes the automorphism group of the graph, by individualization and
+ * refinement of the vertex partitions
+ * @param g The graph we want to know about
+ * @param order If not NULL, the order of preference of the vertices to pick the
+ * base points. The vertices come first in the order of their index otherwise
+ * @return The pointer to the allocated stabilizer chain
+ */
+Symmetry* computeSymmetry(Graph* g, int* order);
+
+/**
+ * Frees the memory of the stabilizer chain
+ * @param s The stabilizer chain to free
+ */
+void freeSymmetry(Symmetry* s);
+
+/**
+ * @param s The stabilizer chain of the group
+ * @return The number of automorphisms, as the product of the orbit sizes
+ */
+double groupOrder(Symmetry* s);
+
+/**
+ * Computes a canonical form of the graph, by individualization and refinement:
+ * two graphs have the same form if and only if they are isomorphic, with an
+ * isomorphism keeping the colors of the vertices and of the edges.
+ * Every leaf of the search tree is a candidate, the smallest form is kept.
+ * Children of a node that are the image of an explored one by an automorphism
+ * are skipped, so symmetric graphs only explore a few leaves.
+ * @param g The graph we want to know about
+ * @param vertexColors The color of each vertex, NULL if they are all the same
+ * @param edgeColors The color of each edge, NULL if they are all the same
+ * @param position The table of size nbv where the position of each vertex in the
+ * canonical order is stored
+ * @param form The table of size nbv+3*nbe where the form is stored: the colors of
+ * the vertices in the canonical order, then the sorted triples (u, v, color) of
+ * the edges, with the positions u <= v of their endpoints
+ */
+void canonicalGraph(Graph* g, int* vertexColors, int* edgeColors, int* position, int* form);
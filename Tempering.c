@@ -0,0 +1,209 @@
+#include "Tempering.h"
+#include "Utils.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern int timeout;
+
+// The number of sweeps between two exchange attempts
+#define EXCHANGE_PERIOD 10
+
+typedef struct _tempering Tempering;
+
+/**
+ * A replica explores its labels at the temperature of its slot
+ */
+typedef struct _replica {
+    Tempering* t;
+    int index;
+    Solver* s;
+    long value;
+    unsigned int seed;
+    // The temperature slot of the replica
+    int slot;
+} Replica;
+
+/**
+ * What the replicas share. A slot is locked by the replica exchanging it,
+ * the others skip the exchange instead of waiting
+ */
+struct _tempering {
+    int method;
+    int k;
+    int l;
+    int d_k;
+    int d_l;
+    long precision;
+    int nbReplicas;
+    float* temperatures;
+    int* slotLocks;
+    // The replica at each temperature slot
+    int* replicaAt;
+    Replica* replicas;
+    // The elements whose label can be swapped
+    int* movable;
+    int nbMovable;
+    int stop;
+    int winner;
+    int exchanges;
+    int accepted;
+};
+
+/**
+ * Tries to exchange the temperature of the replica with the next hotter one
+ */
+void tryExchange(Replica* r) {
+    Tempering* t = r->t;
+    int slot = __atomic_load_n(&r->slot, __ATOMIC_ACQUIRE);
+    if (slot + 1 >= t->nbReplicas) { return; }
+
+    int unlocked = 0;
+    if (!__atomic_compare_exchange_n(&t->slotLocks[slot], &unlocked, 1, 0,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        return;
+    }
+    unlocked = 0;
+    if (__atomic_load_n(&r->slot, __ATOMIC_ACQUIRE) != slot ||
+        !__atomic_compare_exchange_n(&t->slotLocks[slot + 1], &unlocked, 1, 0,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&t->slotLocks[slot], 0, __ATOMIC_RELEASE);
+        return;
+    }
+
+    Replica* other = t->replicas + t->replicaAt[slot + 1];
+    long otherValue = __atomic_load_n(&other->value, __ATOMIC_ACQUIRE);
+    float delta = (float)(r->value - otherValue) *
+                  (1 / t->temperatures[slot] - 1 / t->temperatures[slot + 1]);
+    __atomic_fetch_add(&t->exchanges, 1, __ATOMIC_RELAXED);
+    if (delta >= 0 || (float)rand_r(&r->seed) / RAND_MAX < expf(delta)) {
+        t->replicaAt[slot] = other->index;
+        t->replicaAt[slot + 1] = r->index;
+        __atomic_store_n(&other->slot, slot, __ATOMIC_RELEASE);
+        __atomic_store_n(&r->slot, slot + 1, __ATOMIC_RELEASE);
+        __atomic_fetch_add(&t->accepted, 1, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&t->slotLocks[slot + 1], 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&t->slotLocks[slot], 0, __ATOMIC_RELEASE);
+}
+
+void* replicaWorker(void* arg) {
+    Replica* r = (Replica*)arg;
+    Tempering* t = r->t;
+    Solver* s = r->s;
+
+    for (int sweep = 0; sweep < timeout; sweep++) {
+        for (int move = 0; move < t->nbMovable; move++) {
+            if (__atomic_load_n(&t->stop, __ATOMIC_ACQUIRE)) { return NULL; }
+
+            int a = t->movable[rand_r(&r->seed) % t->nbMovable];
+            int b = t->movable[rand_r(&r->seed) % t->nbMovable];
+            if (a == b) { continue; }
+            swapLabels(s, a, b);
+            long value = objective(t->method, s, t->k, t->l, t->d_k, t->d_l);
+            float temperature = t->temperatures[__atomic_load_n(&r->slot, __ATOMIC_ACQUIRE)];
+            if (value <= r->value ||
+                (float)rand_r(&r->seed) / RAND_MAX < expf((float)(r->value - value) / temperature)) {
+                __atomic_store_n(&r->value, value, __ATOMIC_RELEASE);
+                if (value <= t->precision) {
+                    int none = -1;
+                    __atomic_compare_exchange_n(&t->winner, &none, r->index, 0,
+                                                __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+                    __atomic_store_n(&t->stop, 1, __ATOMIC_RELEASE);
+                    return NULL;
+                }
+            } else {
+                swapLabels(s, a, b);
+            }
+        }
+        if (sweep % EXCHANGE_PERIOD == 0) { tryExchange(r); }
+    }
+    return NULL;
+}
+
+Solver* attemptSolveTempering(int method, Solver* s, int k, int l, int d_k, int d_l,
+                              long precision, int nbReplicas,
+                              int* tabooPermutations, int sizePT) {
+    int nbl = s->nbv + s->nbe;
+    if (nbReplicas < 2) { nbReplicas = 2; }
+    printf("Attempting parallel tempering for %s with %d replicas\n", s->g->name, nbReplicas);
+
+    Tempering t;
+    t.method = method;
+    t.k = k;
+    t.l = l;
+    t.d_k = d_k;
+    t.d_l = d_l;
+    t.precision = precision;
+    t.nbReplicas = nbReplicas;
+    t.stop = 0;
+    t.winner = -1;
+    t.exchanges = 0;
+    t.accepted = 0;
+    t.movable = malloc(nbl * sizeof(int));
+    t.nbMovable = 0;
+    for (int i = 0; i < nbl; i++) {
+        if (!inTab(s->labels[i], tabooPermutations, sizePT)) { t.movable[t.nbMovable++] = i; }
+    }
+
+    // Geometric temperatures, the hottest one accepts swaps worse by half the
+    // number of labels most of the time
+    t.temperatures = malloc(nbReplicas * sizeof(float));
+    float coldest = 0.5f;
+    float hottest = nbl / 2.f > 1 ? nbl / 2.f : 1;
+    for (int i = 0; i < nbReplicas; i++) {
+        t.temperatures[i] = coldest * powf(hottest / coldest, (float)i / (nbReplicas - 1));
+    }
+    t.slotLocks = calloc(nbReplicas, sizeof(int));
+    t.replicaAt = malloc(nbReplicas * sizeof(int));
+    t.replicas = malloc(nbReplicas * sizeof(Replica));
+    pthread_t threads[nbReplicas];
+    for (int i = 0; i < nbReplicas; i++) {
+        Replica* r = t.replicas + i;
+        r->t = &t;
+        r->index = i;
+        r->slot = i;
+        r->seed = rand();
+        r->s = shareSolver(s);
+        // Set before the threads start, the others read it to exchange temperatures
+        r->value = objective(method, r->s, k, l, d_k, d_l);
+        t.replicaAt[i] = i;
+    }
+    // The replicas start from the same labels, which may already be a solution
+    // even when less than two labels can move
+    if (t.replicas[0].value <= precision) {
+        t.winner = 0;
+    } else if (t.nbMovable >= 2) {
+        for (int i = 0; i < nbReplicas; i++) {
+            pthread_create(&threads[i], NULL, replicaWorker, t.replicas + i);
+        }
+        for (int i = 0; i < nbReplicas; i++) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    int winner = t.winner;
+    if (winner != -1) {
+        memcpy(s->labels, t.replicas[winner].s->labels, nbl * sizeof(int));
+        indexLabels(s);
+    }
+    writeSolver(s);
+    printDetails(winner == -1, method, s->g, k, l, d_k, d_l, precision);
+    printf("%d of %d temperature exchanges accepted", t.accepted, t.exchanges);
+    if (winner != -1) {
+        printf(", solved at temperature %.2f", t.temperatures[t.replicas[winner].slot]);
+    }
+    printf("\n");
+
+    for (int i = 0; i < nbReplicas; i++) {
+        freeSolver(t.replicas[i].s, 0);
+    }
+    free(t.replicas);
+    free(t.replicaAt);
+    free(t.slotLocks);
+    free(t.temperatures);
+    free(t.movable);
+    return winner == -1 ? NULL : s;
+}
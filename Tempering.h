@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Solver.h"
+
+/**
+ * Parallel tempering: each replica is a copy of the labels explored by its own
+ * thread with random swaps, accepted with the Metropolis rule at the
+ * temperature of the replica. The temperatures go from cold (only a little worse
+ * labels accepted) to hot (almost random walk). Regularly, each replica tries
+ * to exchange its temperature with the replica at the next temperature, so
+ * that good labels found while hot are refined while cold.
+ *
+ * The first replica to reach the precision stops all the others, and its
+ * labels are copied in s.
+ *
+ * @param 	method the objective, see attemptSolveWithSolver
+ * @param 	s the solver, all the replicas start from its current labels
+ * @param 	k Depends on the method, can be ignored
+ * @param 	l Depends on the method, can be ignored
+ * @param 	d_k Depends on the method, can be ignored
+ * @param 	d_l Depends on the method, can be ignored
+ * @param 	precision the value of the objective to reach, 0 to solve the graph
+ * @param 	nbReplicas the number of replicas, each one on its own thread
+ * @param 	tabooPermutations List of label that will not be permuted, NULL if ignored
+ * @param 	sizePT The size of the provided list, 0 if ignored
+ * @return 	s if a replica reached the precision in at most timeout sweeps, NULL if not
+ */
+Solver* attemptSolveTempering(int method, Solver* s, int k, int l, int d_k, int d_l,
+                              long precision, int nbReplicas,
+                              int* tabooPermutations, int sizePT);
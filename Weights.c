@@ -0,0 +1,197 @@
+#include "Weights.h"
+
+#include <stdlib.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define WEIGHTS_AVX2
+#endif
+
+#ifdef WEIGHTS_AVX2
+
+__attribute__((target("avx2"))) int sumLanes(__m256i v) {
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum);
+}
+
+__attribute__((target("avx2"))) void weightsFromIncidenceAvx2(
+    const int* labels, int nbv, const int* offsets, const int* incidence, int* weights) {
+    const int* edgeLabels = labels + nbv;
+    for (int i = 0; i < nbv; i++) {
+        int j = offsets[i];
+        int end = offsets[i + 1];
+        int res = labels[i];
+        if (end - j >= 8) {
+            __m256i sum = _mm256_setzero_si256();
+            for (; j + 8 <= end; j += 8) {
+                __m256i index = _mm256_loadu_si256((const __m256i*)(incidence + j));
+                sum = _mm256_add_epi32(sum, _mm256_i32gather_epi32(edgeLabels, index, 4));
+            }
+            res += sumLanes(sum);
+        }
+        for (; j < end; j++) {
+            res += edgeLabels[incidence[j]];
+        }
+        weights[i] = res;
+    }
+}
+
+__attribute__((target("avx2"))) void weightsCompleteAvx2(const int* labels, int nbv,
+                                                           int* weights) {
+    const int* row = labels + nbv;
+    for (int i = 0; i < nbv; i++) {
+        weights[i] = labels[i];
+    }
+    for (int i = 0; i < nbv - 1; i++) {
+        // The edges (i, i+1) to (i, nbv-1)
+        int size = nbv - 1 - i;
+        int* next = weights + i + 1;
+        __m256i sum = _mm256_setzero_si256();
+        int t = 0;
+        for (; t + 8 <= size; t += 8) {
+            __m256i edges = _mm256_loadu_si256((const __m256i*)(row + t));
+            sum = _mm256_add_epi32(sum, edges);
+            __m256i w = _mm256_loadu_si256((const __m256i*)(next + t));
+            _mm256_storeu_si256((__m256i*)(next + t), _mm256_add_epi32(w, edges));
+        }
+        int res = sumLanes(sum);
+        for (; t < size; t++) {
+            res += row[t];
+            next[t] += row[t];
+        }
+        weights[i] += res;
+        row += size;
+    }
+}
+
+__attribute__((target("avx2"))) __m256i abs64(__m256i v) {
+    __m256i negative = _mm256_sub_epi64(_mm256_setzero_si256(), v);
+    return _mm256_blendv_epi8(v, negative, _mm256_cmpgt_epi64(negative, v));
+}
+
+__attribute__((target("avx2"))) void incidenceSwapDeltasAvx2(
+    int method, int k, const int* labels, const long* far, int j, long* deltas) {
+    long farJ = far[j];
+    __m256i labelJ = _mm256_set1_epi64x(labels[j]);
+    __m256i farJv = _mm256_set1_epi64x(farJ);
+    __m256i kv = _mm256_set1_epi64x(k);
+    __m256i distanceJ = _mm256_set1_epi64x(labs(farJ - k));
+    int i = 1;
+    for (; i + 4 <= j; i += 4) {
+        __m256i d = _mm256_sub_epi64(
+            labelJ, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(labels + i))));
+        __m256i w = _mm256_loadu_si256((const __m256i*)(far + i));
+        __m256i res;
+        if (method == 0) {
+            __m256i shifted = abs64(_mm256_sub_epi64(_mm256_add_epi64(w, d), kv));
+            __m256i before = abs64(_mm256_sub_epi64(w, kv));
+            __m256i shiftedJ = abs64(_mm256_sub_epi64(_mm256_sub_epi64(farJv, d), kv));
+            res = _mm256_add_epi64(_mm256_sub_epi64(shifted, before),
+                                   _mm256_sub_epi64(shiftedJ, distanceJ));
+        } else {
+            // Both factors fit in 32 bits, the product does not
+            __m256i t = _mm256_add_epi64(_mm256_sub_epi64(w, farJv), d);
+            res = _mm256_slli_epi64(_mm256_mul_epi32(d, t), 1);
+        }
+        _mm256_storeu_si256((__m256i*)(deltas + i), res);
+    }
+    for (; i < j; i++) {
+        long d = labels[j] - labels[i];
+        deltas[i] = method == 0 ? labs(far[i] + d - k) - labs(far[i] - k) +
+                                      labs(farJ - d - k) - labs(farJ - k)
+                                : 2 * d * (far[i] - farJ + d);
+    }
+}
+
+#endif
+
+void incidenceSwapDeltasPortable(int method, int k, const int* labels, const long* far,
+                                 int j, long* deltas) {
+    long farJ = far[j];
+    for (int i = 1; i < j; i++) {
+        long d = labels[j] - labels[i];
+        deltas[i] = method == 0 ? labs(far[i] + d - k) - labs(far[i] - k) +
+                                      labs(farJ - d - k) - labs(farJ - k)
+                                : 2 * d * (far[i] - farJ + d);
+    }
+}
+
+void weightsFromIncidencePortable(const int* labels, int nbv, const int* offsets,
+                                  const int* incidence, int* weights) {
+    const int* edgeLabels = labels + nbv;
+    for (int i = 0; i < nbv; i++) {
+        int res = labels[i];
+        for (int j = offsets[i]; j < offsets[i + 1]; j++) {
+            res += edgeLabels[incidence[j]];
+        }
+        weights[i] = res;
+    }
+}
+
+void weightsCompletePortable(const int* labels, int nbv, int* weights) {
+    const int* row = labels + nbv;
+    for (int i = 0; i < nbv; i++) {
+        weights[i] = labels[i];
+    }
+    for (int i = 0; i < nbv - 1; i++) {
+        int size = nbv - 1 - i;
+        int* next = weights + i + 1;
+        int res = 0;
+        for (int t = 0; t < size; t++) {
+            res += row[t];
+            next[t] += row[t];
+        }
+        weights[i] += res;
+        row += size;
+    }
+}
+
+#ifdef WEIGHTS_AVX2
+/**
+ * @return 1 if the processor supports AVX2, checked only once
+ */
+int hasAvx2() {
+    static int supported = -1;
+    int res = __atomic_load_n(&supported, __ATOMIC_RELAXED);
+    if (res == -1) {
+        __builtin_cpu_init();
+        res = __builtin_cpu_supports("avx2") != 0;
+        __atomic_store_n(&supported, res, __ATOMIC_RELAXED);
+    }
+    return res;
+}
+#endif
+
+void weightsFromIncidence(const int* labels, int nbv, const int* offsets,
+                          const int* incidence, int* weights) {
+#ifdef WEIGHTS_AVX2
+    if (hasAvx2()) {
+        weightsFromIncidenceAvx2(labels, nbv, offsets, incidence, weights);
+        return;
+    }
+#endif
+    weightsFromIncidencePortable(labels, nbv, offsets, incidence, weights);
+}
+
+void weightsComplete(const int* labels, int nbv, int* weights) {
+#ifdef WEIGHTS_AVX2
+    if (hasAvx2()) {
+        weightsCompleteAvx2(labels, nbv, weights);
+        return;
+    }
+#endif
+    weightsCompletePortable(labels, nbv, weights);
+}
+
+void incidenceSwapDeltas(int method, int k, const int* labels, const long* far, int j,
+                         long* deltas) {
+#ifdef WEIGHTS_AVX2
+    if (hasAvx2()) {
+        incidenceSwapDeltasAvx2(method, k, labels, far, j, deltas);
+        return;
+    }
+#endif
+    incidenceSwapDeltasPortable(method, k, labels, far, j, deltas);
+}
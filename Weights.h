@@ -0,0 +1,49 @@
+#pragma once
+
+/**
+ * Kernels computing the weight of every vertex, the sum of its label and of
+ * the labels of its issued edges. The AVX2 version is used when the processor
+ * supports it, a portable version otherwise.
+ *
+ * The labels are indexed like in a solver, the vertices first, then the edges.
+ */
+
+/**
+ * Computes the weights from the incidence lists of the vertices
+ * @param labels The labels of the vertices then of the edges
+ * @param nbv The number of vertices
+ * @param offsets The edges issued from the vertex i are incidence[offsets[i]]
+ * to incidence[offsets[i+1]-1]
+ * @param incidence The indices of the edges issued from each vertex
+ * @param weights The table of size nbv where the weights are stored
+ */
+void weightsFromIncidence(const int* labels, int nbv, const int* offsets,
+                          const int* incidence, int* weights);
+
+/**
+ * Computes the weights of a complete graph whose edges are in the order
+ * (0,1), (0,2), ..., (0,n-1), (1,2), ..., (n-2,n-1). The edges issued from a
+ * vertex towards the next vertices are then contiguous, so the labels are read
+ * in order without looking at the incidence lists
+ * @param labels The labels of the vertices then of the edges
+ * @param nbv The number of vertices
+ * @param weights The table of size nbv where the weights are stored
+ */
+void weightsComplete(const int* labels, int nbv, int* weights);
+
+/**
+ * Scores at once the swaps of the edge j issued from a vertex with the edges 1 to j-1
+ * issued from it. The weight of the vertex does not change, only the far endpoints
+ * of the two edges change, by d and -d, so the sum of the weights does not change
+ * either. The far endpoints must be different vertices
+ * @param method 0 for the sum of the distances of the weights to k, 2 for the sum
+ * of their squares
+ * @param k The magic constant, used by the method 0
+ * @param labels The labels of the vertex, then of its issued edges
+ * @param far The weights of the far endpoints of the issued edges, at the same indices
+ * @param j The index of the edge swapped with the previous ones
+ * @param deltas Where the change of the sum of each swap is stored, at the index
+ * of the other edge
+ */
+void incidenceSwapDeltas(int method, int k, const int* labels, const long* far, int j,
+                         long* deltas);